@@ -20,17 +20,29 @@
 
 #include <iostream>
 #include <csignal>
+#include <cstdio>
 
 #include "bridges/Generic.h"
 #include "bridges/SQMidi.h"
 #include "bridges/SQMitm.h"
 
+#include "Latency.h"
 #include "log.h"
+#include "Metrics.h"
 
 #if defined(__APPLE__)
 #include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
 #include <arpa/inet.h>
+#else
+#include <pthread.h>
+#endif
 
+#if defined(__linux__)
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #endif
 
 namespace LisaDeskbridge {
@@ -48,9 +60,21 @@ namespace LisaDeskbridge {
 
         CFRunLoopStop(runLoopRef);
     }
+
+    static void stats_signal_handler(void * context){
+        static_cast<Bridge*>(context)->logStats();
+    }
 #endif
 
     Bridge::Bridge(BridgeOpts &opts) : lisaControllerProxy_(this){
+        for(std::atomic<bool> & alive : controllerAlive_){
+            alive = true;
+        }
+
+        if (opts.contains(kOptHiresFaders)){
+            hiresFaders_ = atoi(opts[kOptHiresFaders].data()) == 1;
+        }
+
 //        if (bridgeSingleton != nullptr){
 //            throw std::logic_error("Bridge is a singleton ");
 //        }
@@ -78,11 +102,49 @@ namespace LisaDeskbridge {
             }
 
             if (opts.contains(kOptLisaControllerIp)){
-                struct sockaddr_in addr;
-                if (inet_aton(opts[kOptLisaControllerIp].data(), (struct in_addr*)&(addr.sin_addr.s_addr)) != 1){
-                    throw std::invalid_argument("invalid lisa controller ip");
+                std::string & list = opts[kOptLisaControllerIp];
+
+                if (list.find_first_of(",:") == std::string::npos){
+                    struct sockaddr_in addr;
+                    if (inet_aton(list.data(), (struct in_addr*)&(addr.sin_addr.s_addr)) != 1){
+                        throw std::invalid_argument("invalid lisa controller ip");
+                    }
+                    bridge->lisaControllerIp_ = list;
+                } else {
+                    // ip[:port][,ip[:port]..]
+                    size_t start = 0;
+                    while(start <= list.length()){
+                        size_t end = list.find(',', start);
+                        if (end == std::string::npos){
+                            end = list.length();
+                        }
+                        std::string entry = list.substr(start, end - start);
+                        start = end + 1;
+
+                        LisaControllerProxy::ControllerAddress controller = {entry, 0};
+
+                        size_t colon = entry.find(':');
+                        if (colon != std::string::npos){
+                            controller.address = entry.substr(0, colon);
+                            int i = atoi(entry.data() + colon + 1);
+                            if (i < 1 || 0xffff < i){
+                                throw std::invalid_argument("invalid lisa controller port");
+                            }
+                            controller.port = i;
+                        }
+
+                        struct sockaddr_in addr;
+                        if (inet_aton(controller.address.data(), (struct in_addr*)&(addr.sin_addr.s_addr)) != 1){
+                            throw std::invalid_argument("invalid lisa controller ip");
+                        }
+
+                        bridge->lisaControllers_.push_back(controller);
+                    }
+                    if (bridge->lisaControllers_.size() > LisaControllerProxy::kMaxControllers){
+                        throw std::invalid_argument("too many lisa controllers");
+                    }
+                    bridge->lisaControllerIp_ = bridge->lisaControllers_[0].address;
                 }
-                bridge->lisaControllerIp_ = opts[kOptLisaControllerIp];
             }
             if (opts.contains(kOptLisaControllerPort)){
                 int i = atoi(opts[kOptLisaControllerPort].data());
@@ -121,9 +183,99 @@ namespace LisaDeskbridge {
             if (opts.contains(kOptClaimLevelControl)){
                 bridge->claimLevelControl_ = atoi(opts[kOptClaimLevelControl].data()) == 1;
             }
+            if (opts.contains(kOptRelativeFlushRate)){
+                int i = atoi(opts[kOptRelativeFlushRate].data());
+                if (i < 0 || (int)LisaControllerProxy::kRelativeFlushRateMax < i){
+                    throw std::invalid_argument("relative-flush-rate must be between 0 - 1000");
+                }
+                bridge->relativeFlushRate_ = i;
+            }
+            for(int p = -1; p < RelativeParamCount; p++){
+                // -1: all parameters
+                std::string suffix = p < 0 ? "" : std::string("-") + EncoderAcceleration::paramName((RelativeParam_t)p);
+                int first = p < 0 ? 0 : p;
+                int last = p < 0 ? RelativeParamCount - 1 : p;
+
+                std::string step = kOptRelativeStep + suffix;
+                if (opts.contains(step)){
+                    float f = atof(opts[step].data());
+                    if (f <= 0.0 || 1.0 < f){
+                        throw std::invalid_argument(step + " must be between 0 - 1");
+                    }
+                    for(int i = first; i <= last; i++){
+                        bridge->encoderAcceleration_.curve((RelativeParam_t)i).stepSize = f;
+                    }
+                }
+
+                std::string accel = kOptRelativeAccel + suffix;
+                if (opts.contains(accel)){
+                    float f = atof(opts[accel].data());
+                    if (f < 1.0){
+                        throw std::invalid_argument(accel + " must be at least 1");
+                    }
+                    for(int i = first; i <= last; i++){
+                        bridge->encoderAcceleration_.curve((RelativeParam_t)i).maxFactor = f;
+                    }
+                }
+            }
+            if (opts.contains(kOptMidiOutRate)){
+                int i = atoi(opts[kOptMidiOutRate].data());
+                if (i < 0 || (int)MidiSender_Single_Impl::kOutputRateMax < i){
+                    throw std::invalid_argument("midi-out-rate must be between 0 - 1000");
+                }
+                bridge->midiOutRate_ = i;
+            }
+            if (opts.contains(kOptValueCacheEpsilon)){
+                bridge->valueCacheEpsilon_ = atof(opts[kOptValueCacheEpsilon].data());
+            }
+            if (opts.contains(kOptValueCacheMaxAge)){
+                int i = atoi(opts[kOptValueCacheMaxAge].data());
+                if (i < 0){
+                    throw std::invalid_argument("value-cache-max-age must not be negative");
+                }
+                bridge->valueCacheMaxAge_ = i;
+            }
+            if (opts.contains(kOptMetricsFile)){
+                bridge->metricsFile_ = opts[kOptMetricsFile];
+            }
+            if (opts.contains(kOptEventLoop)){
+                if (opts[kOptEventLoop] == "epoll"){
+#if defined(__linux__)
+                    bridge->useReactor_ = true;
+#else
+                    throw std::invalid_argument("event-loop epoll is only available on Linux");
+#endif
+                } else if (opts[kOptEventLoop] != "threads"){
+                    throw std::invalid_argument("event-loop must be threads or epoll");
+                }
+            }
+            if (opts.contains(kOptMetricsInterval)){
+                int i = atoi(opts[kOptMetricsInterval].data());
+                if (i < 1){
+                    throw std::invalid_argument("metrics-interval must be positive");
+                }
+                bridge->metricsInterval_ = i;
+            }
+            if (opts.contains(kOptPingInterval)){
+                int i = atoi(opts[kOptPingInterval].data());
+                if (i < 0){
+                    throw std::invalid_argument("ping-interval must not be negative");
+                }
+                bridge->pingInterval_ = i;
+            }
+            if (opts.contains(kOptPingTimeout)){
+                int i = atoi(opts[kOptPingTimeout].data());
+                if (i < 1){
+                    throw std::invalid_argument("ping-timeout must be positive");
+                }
+                bridge->pingTimeout_ = i;
+            }
+            if (bridge->pingInterval_ != 0 && bridge->pingTimeout_ <= bridge->pingInterval_){
+                throw std::invalid_argument("ping-timeout must be greater than ping-interval");
+            }
 
         } catch (std::exception &e){
-            log(LogLevelDebug, "Exception when creating bridge: %s", e.what());
+            LISA_LOG(LogLevelDebug, "Exception when creating bridge: %s", e.what());
         }
         return bridge;
     }
@@ -136,24 +288,72 @@ namespace LisaDeskbridge {
 
         state = State_Starting;
 
-        log(LogLevelInfo, "Starting bridge..");
+        LISA_LOG(LogLevelInfo, "Starting bridge..");
+
+#if !defined(__APPLE__)
+        // SIGUSR1 (stats) is taken care of by runloop() (using sigwait), which requires any thread to block it.
+        // Threads inherit the mask from their creator, so this covers all threads started from here on.
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGUSR1);
+        if (useReactor_){
+            // all handled through a signalfd
+            sigaddset(&set, SIGHUP);
+            sigaddset(&set, SIGINT);
+            sigaddset(&set, SIGTERM);
+        }
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+#endif
+
+        if (useReactor_){
+            if (reactor_.open() == false){
+                state = State_Stopped;
+                return false;
+            }
+            MidiReceiver::setReactor(&reactor_);
+
+            LISA_LOG(LogLevelInfo, "Using epoll event loop");
+        }
 
         if (startLisaControllerProxy() == false){
+            closeReactor();
             state = State_Stopped;
             return false;
         }
 
         if (startImpl() == false){
             stopLisaControllerProxy();
+            closeReactor();
             state = State_Stopped;
             return false;
         }
 
-        lisaControllerProxy_.registerDevice(deviceId_, deviceIp_.data(), devicePort_);
-        lisaControllerProxy_.setDeviceName(deviceId_, deviceName_.data());
+        {
+            LisaControllerProxy::BundleScope bundle(lisaControllerProxy_);
+
+            lisaControllerProxy_.registerDevice(deviceId_, deviceIp_.data(), devicePort_);
+            lisaControllerProxy_.setDeviceName(deviceId_, deviceName_.data());
+
+            if (claimLevelControl_){
+                claimLisaControllerLevelControl(true);
+            }
+        }
+
+        startLiveness();
 
-        if (claimLevelControl_){
-            claimLisaControllerLevelControl(true);
+        if (metricsFile_.length() > 0){
+            LISA_LOG(LogLevelInfo, "Writing metrics to %s every %d ms", metricsFile_.data(), metricsInterval_);
+
+            metricsFailed_ = false;
+            if (reactor() != nullptr){
+                metricsTimer_ = reactor_.addTimer(std::chrono::milliseconds(metricsInterval_), [this](){
+                    writeMetrics();
+                });
+            } else {
+                metricsTask_.start(std::chrono::milliseconds(metricsInterval_), [this](){
+                    writeMetrics();
+                });
+            }
         }
 
         state = State_Started;
@@ -161,10 +361,30 @@ namespace LisaDeskbridge {
         return true;
     }
 
+    bool Bridge::startDetached(Transport & transport){
+
+        if (state == State_Started){
+            return true;
+        }
+
+        state = State_Starting;
+
+        LISA_LOG(LogLevelInfo, "Starting bridge (detached)..");
+
+        configureLisaControllerProxy();
+
+        lisaControllerProxy_.startDetached(transport);
+
+        detached_ = true;
+        state = State_Started;
+
+        return true;
+    }
+
     void Bridge::runloop(){
 
 
-        log(LogLevelInfo, "Running loops..");
+        LISA_LOG(LogLevelInfo, "Running loops..");
 
 #if defined(__APPLE__)
 // On macOS, observation can *only* be done in the main thread
@@ -181,33 +401,213 @@ namespace LisaDeskbridge {
         std::signal(SIGINT, stop_runloop_signal_handler);
         std::signal(SIGTERM, stop_runloop_signal_handler);
 
+        std::signal(SIGUSR1, SIG_IGN);
+        dispatch_source_t statsSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGUSR1, 0, dispatch_get_main_queue());
+        dispatch_set_context(statsSource, this);
+        dispatch_source_set_event_handler_f(statsSource, stats_signal_handler);
+        dispatch_resume(statsSource);
+
         CFRunLoopRun();
+
+        dispatch_source_cancel(statsSource);
+        dispatch_release(statsSource);
 #else
+        if (reactor() != nullptr){
+            // signals are taken care of by the event loop itself
+            runReactor();
+
+            LISA_LOG(LogLevelInfo, "Stopping..");
+            return;
+        }
+
         sigset_t wset;
         sigemptyset(&wset);
         sigaddset(&wset,SIGHUP);
         sigaddset(&wset,SIGINT);
         sigaddset(&wset,SIGTERM);
+        sigaddset(&wset,SIGUSR1);
         int sig;
-        sigwait(&wset,&sig);
+        do {
+            sigwait(&wset,&sig);
+            if (sig == SIGUSR1){
+                logStats();
+            }
+        } while(sig == SIGUSR1);
 
-        log(LogLevelInfo, "Stopping..");
+        LISA_LOG(LogLevelInfo, "Stopping..");
 #endif
 
     }
 
     void Bridge::stopRunloop(){
 
-        log(LogLevelInfo, "Stopping runloop!");
+        LISA_LOG(LogLevelInfo, "Stopping runloop!");
 
 #if defined(__APPLE__)
         CFRunLoopStop(runLoopRef);
 #else
-        std::raise(SIGTERM);
+        if (reactor() != nullptr){
+            reactor_.stop();
+        } else {
+            std::raise(SIGTERM);
+        }
+#endif
+
+    }
+
+
+    void Bridge::runReactor(){
+#if defined(__linux__)
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGHUP);
+        sigaddset(&set, SIGINT);
+        sigaddset(&set, SIGTERM);
+        sigaddset(&set, SIGUSR1);
+
+        int fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd == -1){
+            LISA_LOG(LogLevelError, "signalfd failed: %s", strerror(errno));
+            return;
+        }
+
+        reactor_.watch(fd, [this, fd](){
+            struct signalfd_siginfo info;
+            while(read(fd, &info, sizeof(info)) == sizeof(info)){
+                if (info.ssi_signo == SIGUSR1){
+                    logStats();
+                } else {
+                    reactor_.stop();
+                }
+            }
+        });
+
+        reactor_.run();
+
+        reactor_.unwatch(fd);
+        close(fd);
 #endif
+    }
+
+    void Bridge::closeReactor(){
+        if (reactor_.isOpen()){
+            MidiReceiver::setReactor(nullptr);
+            reactor_.close();
+        }
+    }
+
+    float Bridge::relativeStep(RelativeParam_t param, int ticks, uint64_t time){
+        if (time == 0){
+            time = currentIngress != 0 ? ingressTime(currentIngress) : latencyNow();
+        }
+        return encoderAcceleration_.step(param, ticks, time);
+    }
+
+    void Bridge::logStats(bool reset){
+
+        LisaControllerProxy::TxStats tx = lisaControllerProxy_.getTxStats();
+
+        LISA_LOG(LogLevelInfo, "TX: %llu sent (%llu system calls), %llu dropped, %d queued",
+                 (unsigned long long)tx.sent, (unsigned long long)tx.syscalls, (unsigned long long)tx.dropped, (int)tx.depth);
+
+        LISA_LOG(LogLevelInfo, "RX: %llu datagrams in %llu batches, %llu values coalesced",
+                 (unsigned long long)metrics.oscRxDatagrams.get(), (unsigned long long)metrics.oscRxBatches.get(),
+                 (unsigned long long)metrics.oscRxCoalesced.get());
+
+        LatencyHistogram::Summary rtt = lisaControllerProxy_.getPingRtt().summarize();
+        if (rtt.count > 0){
+            LISA_LOG(LogLevelInfo, "Ping RTT: n = %llu, p50 = %.1f us, p99 = %.1f us, max = %.1f us, %s",
+                     (unsigned long long)rtt.count, rtt.p50 / 1000.0, rtt.p99 / 1000.0, rtt.max / 1000.0,
+                     isLisaControllerAlive() ? "alive" : "not responding");
+        }
+        if (reset){
+            lisaControllerProxy_.getPingRtt().reset();
+        }
+
+        for(int source = 0; source < LatencySourceCount; source++){
+            LatencyHistogram & histogram = lisaControllerProxy_.getLatency((LatencySource_t)source);
+            LatencyHistogram::Summary summary = histogram.summarize();
+
+            if (summary.count > 0){
+                LISA_LOG(LogLevelInfo, "Latency %s -> OSC: n = %llu, p50 = %.1f us, p99 = %.1f us, max = %.1f us",
+                         latencySourceName((LatencySource_t)source), (unsigned long long)summary.count,
+                         summary.p50 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0);
+            }
 
+            if (reset){
+                histogram.reset();
+            }
+        }
     }
 
+    void Bridge::writeMetrics(){
+
+        // write to a temporary file and move it in place, such that readers never see a partial file
+        std::string tmpFile = metricsFile_ + ".tmp";
+
+        FILE * file = fopen(tmpFile.data(), "w");
+        if (file == nullptr){
+            if (!metricsFailed_){
+                logError("Could not write metrics to %s", tmpFile.data());
+                metricsFailed_ = true;
+            }
+            return;
+        }
+
+        metrics.writePrometheus(file);
+
+        LisaControllerProxy::TxStats tx = lisaControllerProxy_.getTxStats();
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_tx_datagrams_total", "counter", "Datagrams sent to L-ISA Controller");
+        writePrometheusValue(file, "lisa_deskbridge_osc_tx_datagrams_total", tx.sent);
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_tx_syscalls_total", "counter", "System calls it took to send the datagrams (less than datagrams thanks to batching)");
+        writePrometheusValue(file, "lisa_deskbridge_osc_tx_syscalls_total", tx.syscalls);
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_tx_dropped_total", "counter", "Datagrams dropped because the TX queue was full");
+        writePrometheusValue(file, "lisa_deskbridge_osc_tx_dropped_total", tx.dropped);
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_tx_queue_depth", "gauge", "Datagrams waiting to be sent");
+        writePrometheusValue(file, "lisa_deskbridge_osc_tx_queue_depth", tx.depth);
+
+        writePrometheusHeader(file, "lisa_deskbridge_value_cache_suppressed_total", "counter", "Sends skipped because the value did not change");
+        writePrometheusValue(file, "lisa_deskbridge_value_cache_suppressed_total", lisaControllerProxy_.getValueCache().getSuppressedCount());
+
+        LatencyHistogram::Summary rtt = lisaControllerProxy_.getPingRtt().summarize();
+
+        writePrometheusHeader(file, "lisa_deskbridge_controller_ping_rtt_microseconds", "summary", "Round trip time of pings to L-ISA Controller");
+        writePrometheusValue(file, "lisa_deskbridge_controller_ping_rtt_microseconds", rtt.p50 / 1000, "quantile", "0.5");
+        writePrometheusValue(file, "lisa_deskbridge_controller_ping_rtt_microseconds", rtt.p99 / 1000, "quantile", "0.99");
+        writePrometheusValue(file, "lisa_deskbridge_controller_ping_rtt_microseconds", rtt.max / 1000, "quantile", "1");
+        writePrometheusValue(file, "lisa_deskbridge_controller_ping_rtt_microseconds_count", rtt.count);
+
+        writePrometheusHeader(file, "lisa_deskbridge_controller_up", "gauge", "Whether L-ISA Controller replies to pings");
+        for(unsigned int i = 0; i < lisaControllerProxy_.getControllerCount(); i++){
+            writePrometheusValue(file, "lisa_deskbridge_controller_up", controllerAlive_[i] ? 1 : 0,
+                                 "controller", lisaControllerProxy_.getControllerName(i).data());
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_controller_active", "gauge", "Whether feedback is taken from this L-ISA Controller");
+        for(unsigned int i = 0; i < lisaControllerProxy_.getControllerCount(); i++){
+            writePrometheusValue(file, "lisa_deskbridge_controller_active", lisaControllerProxy_.getActiveController() == i ? 1 : 0,
+                                 "controller", lisaControllerProxy_.getControllerName(i).data());
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_controller_failovers_total", "counter", "Times feedback was switched to another L-ISA Controller");
+        writePrometheusValue(file, "lisa_deskbridge_controller_failovers_total", failovers_.load(std::memory_order_relaxed));
+
+        writePrometheusHeader(file, "lisa_deskbridge_controller_reregistrations_total", "counter", "Times the device was registered again after L-ISA Controller came back");
+        writePrometheusValue(file, "lisa_deskbridge_controller_reregistrations_total", reregistrations_.load(std::memory_order_relaxed));
+
+        fclose(file);
+
+        if (rename(tmpFile.data(), metricsFile_.data()) != 0){
+            if (!metricsFailed_){
+                logError("Could not write metrics to %s", metricsFile_.data());
+                metricsFailed_ = true;
+            }
+        }
+    }
 
     void Bridge::stop(){
 
@@ -217,18 +617,63 @@ namespace LisaDeskbridge {
 
         state = State_Stopping;
 
+        metricsTask_.stop();
+        if (metricsTimer_ != -1){
+            reactor_.removeTimer(metricsTimer_);
+            metricsTimer_ = -1;
+        }
+
+        stopLiveness();
+
+        if (detached_){
+            lisaControllerProxy_.stop();
+            detached_ = false;
+            state = State_Stopped;
+            return;
+        }
+
         stopImpl();
 
         stopLisaControllerProxy();
 
+        closeReactor();
+
+        if (metricsFile_.length() > 0){
+            writeMetrics();
+        }
+
         state = State_Stopped;
     }
 
+    void Bridge::configureLisaControllerProxy(){
+        lisaControllerProxy_.setRelativeFlushRate(relativeFlushRate_);
+
+        if (valueCacheEpsilon_ < 0.0f){
+            lisaControllerProxy_.getValueCache().setEnabled(false);
+        } else {
+            lisaControllerProxy_.getValueCache().setEnabled(true);
+            lisaControllerProxy_.getValueCache().setEpsilon(valueCacheEpsilon_);
+            lisaControllerProxy_.getValueCache().setMaxAge(valueCacheMaxAge_);
+        }
+    }
+
     bool Bridge::startLisaControllerProxy(){
-        log(LogLevelInfo,  "Starting L-ISA Controller Proxy.." );
+        LISA_LOG(LogLevelInfo,  "Starting L-ISA Controller Proxy.." );
+
+        configureLisaControllerProxy();
 
         try {
-            lisaControllerProxy_.start(devicePort_, lisaControllerIp_, lisaControllerPort_);
+            if (lisaControllers_.empty()){
+                lisaControllerProxy_.start(devicePort_, lisaControllerIp_, lisaControllerPort_, reactor());
+            } else {
+                std::vector<LisaControllerProxy::ControllerAddress> controllers = lisaControllers_;
+                for(LisaControllerProxy::ControllerAddress & controller : controllers){
+                    if (controller.port == 0){
+                        controller.port = lisaControllerPort_;
+                    }
+                }
+                lisaControllerProxy_.start(devicePort_, controllers, reactor());
+            }
         } catch (const std::exception& e){
             std::cout << e.what() << std::endl;
             return false;
@@ -238,7 +683,7 @@ namespace LisaDeskbridge {
     }
 
     void Bridge::stopLisaControllerProxy(){
-        log(LogLevelInfo,  "Stopping L-ISA Controller Proxy.." );
+        LISA_LOG(LogLevelInfo,  "Stopping L-ISA Controller Proxy.." );
 
         enableLisaControllerReceivingFromSelf(false);
         enableLisaControllerSendingToSelf(false);
@@ -248,15 +693,138 @@ namespace LisaDeskbridge {
 
 
     void Bridge::enableLisaControllerReceivingFromSelf(bool enable){
+        receivingFromSelf_ = enable;
         lisaControllerProxy_.enableReceivingFromDevice(deviceId_, enable);
     }
 
     void Bridge::enableLisaControllerSendingToSelf(bool enable){
+        sendingToSelf_ = enable;
         lisaControllerProxy_.enableSendingToDevice(deviceId_, enable);
     }
 
     void Bridge::claimLisaControllerLevelControl(bool claim){
+        levelControlClaimed_ = claim;
         lisaControllerProxy_.setMasterGainControl(deviceId_,claim);
     }
 
+    void Bridge::registerWithLisaController(){
+        LisaControllerProxy::BundleScope bundle(lisaControllerProxy_);
+
+        lisaControllerProxy_.registerDevice(deviceId_, deviceIp_.data(), devicePort_);
+        lisaControllerProxy_.setDeviceName(deviceId_, deviceName_.data());
+
+        if (sendingToSelf_){
+            lisaControllerProxy_.enableSendingToDevice(deviceId_, true);
+        }
+        if (receivingFromSelf_){
+            lisaControllerProxy_.enableReceivingFromDevice(deviceId_, true);
+        }
+        if (levelControlClaimed_){
+            lisaControllerProxy_.setMasterGainControl(deviceId_, true);
+        }
+    }
+
+    void Bridge::startLiveness(){
+        if (pingInterval_ == 0){
+            return;
+        }
+
+        for(std::atomic<bool> & alive : controllerAlive_){
+            alive = true;
+        }
+        livenessSince_ = latencyNow();
+        lastPing_ = 0;
+
+        // ticks at the (faster) retry interval, checkLiveness() decides whether to actually ping
+        std::chrono::milliseconds period(pingInterval_ < kPingRetryInterval ? pingInterval_ : kPingRetryInterval);
+
+        if (reactor() != nullptr){
+            livenessTimer_ = reactor_.addTimer(period, [this](){
+                checkLiveness();
+            });
+        } else {
+            livenessTask_.start(period, [this](){
+                checkLiveness();
+            });
+        }
+    }
+
+    void Bridge::stopLiveness(){
+        if (livenessTimer_ != -1){
+            reactor_.removeTimer(livenessTimer_);
+            livenessTimer_ = -1;
+        }
+        livenessTask_.stop();
+    }
+
+    void Bridge::checkLiveness(){
+        uint64_t now = latencyNow();
+
+        bool anyGone = false;
+
+        for(unsigned int i = 0; i < lisaControllerProxy_.getControllerCount(); i++){
+            uint64_t last = lisaControllerProxy_.getLastPong(i);
+            if (last < livenessSince_){
+                last = livenessSince_;
+            }
+
+            if (controllerAlive_[i] && now - last > (uint64_t)pingTimeout_ * 1000000){
+                controllerAlive_[i] = false;
+                logError("L-ISA Controller %s not responding (no reply to ping for %u ms)",
+                         lisaControllerProxy_.getControllerName(i).data(), pingTimeout_);
+            }
+
+            anyGone = anyGone || !controllerAlive_[i];
+        }
+
+        if (!isLisaControllerAlive()){
+            failover();
+        }
+
+        // ping fast while any is gone, such that we register again as soon as it is back
+        uint64_t interval = (uint64_t)(anyGone ? kPingRetryInterval : pingInterval_) * 1000000;
+
+        if (now - lastPing_ >= interval){
+            lastPing_ = now;
+            lisaControllerProxy_.ping(deviceIp_.data(), devicePort_);
+        }
+    }
+
+    void Bridge::failover(){
+        unsigned int active = lisaControllerProxy_.getActiveController();
+
+        for(unsigned int i = 0; i < lisaControllerProxy_.getControllerCount(); i++){
+            if (i != active && controllerAlive_[i]){
+                LISA_LOG(LogLevelInfo, "Failing over from L-ISA Controller %s to %s",
+                         lisaControllerProxy_.getControllerName(active).data(), lisaControllerProxy_.getControllerName(i).data());
+
+                lisaControllerProxy_.setActiveController(i);
+                lisaControllerProxy_.forgetControllerState();
+                failovers_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    void Bridge::receivedPong(unsigned int controller, uint64_t rtt){
+        if (controllerAlive_[controller].exchange(true)){
+            return;
+        }
+
+        LISA_LOG(LogLevelInfo, "L-ISA Controller %s responding again (rtt = %.1f us), registering device",
+                 lisaControllerProxy_.getControllerName(controller).data(), rtt / 1000.0);
+
+        reregistrations_.fetch_add(1, std::memory_order_relaxed);
+
+        // it may have restarted, having lost whatever we sent
+        lisaControllerProxy_.forgetControllerState();
+
+        // sent to all controllers, which does not bother the others
+        registerWithLisaController();
+
+        if (!isLisaControllerAlive()){
+            failover();
+        }
+    }
+
 }
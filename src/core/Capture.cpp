@@ -0,0 +1,224 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Capture.h"
+#include "Latency.h"
+#include "MpscQueue.h"
+#include "log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace LisaDeskbridge {
+
+    std::atomic<bool> capturing{false};
+
+    static constexpr std::size_t kCaptureQueueCapacity = 1024;
+    static constexpr std::size_t kCaptureSlotSize = 4096; // data of a record, larger ones are dropped
+    static constexpr std::chrono::milliseconds kCapturePollInterval(20);
+
+    struct CaptureSlot {
+        uint64_t time;
+        uint8_t type;
+        uint8_t port;
+        uint16_t size;
+        char data[kCaptureSlotSize];
+    };
+
+    // start/stop
+    static std::mutex captureMutex;
+    static FILE * captureFile = nullptr;
+
+    // records are handed over to a writer thread, such that a stalling disk never blocks the capturing threads
+    static MpscQueue<CaptureSlot, kCaptureQueueCapacity> * captureQueue = nullptr;
+    static std::thread * captureThread = nullptr;
+    static std::mutex captureWakeMutex;
+    static std::condition_variable captureCv;
+    static std::atomic<bool> captureStop{false};
+    static std::atomic<uint64_t> captureDropped{0};
+
+    static void captureWrite(const CaptureSlot & slot){
+        char header[kCaptureRecordHeaderSize];
+        std::memcpy(header, &slot.time, 8);
+        std::memcpy(header + 8, &slot.type, 1);
+        std::memcpy(header + 9, &slot.port, 1);
+        std::memcpy(header + 10, &slot.size, 2);
+
+        fwrite(header, 1, sizeof(header), captureFile);
+        fwrite(slot.data, 1, slot.size, captureFile);
+    }
+
+    static void captureRun(){
+        for(;;){
+            bool stop = captureStop.load(std::memory_order_acquire);
+
+            while(captureQueue->pop(captureWrite)){
+                // until drained
+            }
+
+            if (stop){
+                return;
+            }
+
+            // capturing threads never notify (as to never block), so just poll
+            std::unique_lock<std::mutex> lock(captureWakeMutex);
+            captureCv.wait_for(lock, kCapturePollInterval, [](){
+                return captureStop.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    bool startCapture(const char * path){
+        std::lock_guard<std::mutex> lock(captureMutex);
+
+        if (captureFile != nullptr){
+            return false;
+        }
+
+        captureFile = fopen(path, "wb");
+        if (captureFile == nullptr){
+            LISA_LOG(LogLevelError, "Could not open capture file %s", path);
+            return false;
+        }
+
+        setvbuf(captureFile, nullptr, _IOFBF, 1 << 16);
+
+        char header[kCaptureHeaderSize];
+        std::memcpy(header, kCaptureMagic, sizeof(kCaptureMagic));
+        header[kCaptureHeaderSize - 1] = kCaptureVersion;
+        fwrite(header, 1, sizeof(header), captureFile);
+
+        // NOTE never deleted, a thread might still be capturing while capture is stopped
+        if (captureQueue == nullptr){
+            captureQueue = new MpscQueue<CaptureSlot, kCaptureQueueCapacity>();
+        }
+
+        // whatever came in late during a previous capture does not belong to this one
+        while(captureQueue->pop([](CaptureSlot &){})){
+            // until drained
+        }
+
+        captureDropped.store(0, std::memory_order_relaxed);
+        captureStop = false;
+        captureThread = new std::thread(captureRun);
+
+        capturing.store(true, std::memory_order_release);
+
+        LISA_LOG(LogLevelInfo, "Capturing to %s", path);
+
+        return true;
+    }
+
+    void stopCapture(){
+        std::lock_guard<std::mutex> lock(captureMutex);
+
+        if (captureFile == nullptr){
+            return;
+        }
+
+        capturing.store(false, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> wakeLock(captureWakeMutex);
+            captureStop = true;
+        }
+        captureCv.notify_one();
+
+        captureThread->join();
+        delete captureThread;
+        captureThread = nullptr;
+
+        fclose(captureFile);
+        captureFile = nullptr;
+
+        uint64_t dropped = captureDropped.load(std::memory_order_relaxed);
+        if (dropped > 0){
+            LISA_LOG(LogLevelError, "Dropped %llu capture records", (unsigned long long)dropped);
+        }
+    }
+
+    void captureRecord(CaptureRecord_t type, uint8_t port, const void * data, std::size_t size){
+        if (kCaptureSlotSize < size){
+            captureDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // inputs are stamped with their arrival time (if known), sent datagrams with the time they are sent
+        uint64_t time = type != CaptureOscTx && currentIngress != 0 ? ingressTime(currentIngress) : latencyNow();
+
+        bool queued = captureQueue->push([&](CaptureSlot & slot){
+            slot.time = time;
+            slot.type = (uint8_t)type;
+            slot.port = port;
+            slot.size = (uint16_t)size;
+            std::memcpy(slot.data, data, size);
+        });
+
+        if (!queued){
+            captureDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool CaptureReader::open(const char * path){
+        close();
+
+        file = fopen(path, "rb");
+        if (file == nullptr){
+            return false;
+        }
+
+        char header[kCaptureHeaderSize];
+        if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+            std::memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0 ||
+            header[kCaptureHeaderSize - 1] != kCaptureVersion){
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void CaptureReader::close(){
+        if (file != nullptr){
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    bool CaptureReader::next(Record & record){
+        char header[kCaptureRecordHeaderSize];
+
+        if (file == nullptr || fread(header, 1, sizeof(header), file) != sizeof(header)){
+            return false;
+        }
+
+        uint8_t type;
+        std::memcpy(&record.time, header, 8);
+        std::memcpy(&type, header + 8, 1);
+        std::memcpy(&record.port, header + 9, 1);
+        std::memcpy(&record.size, header + 10, 2);
+        record.type = (CaptureRecord_t)type;
+
+        return fread(record.data, 1, record.size, file) == record.size;
+    }
+
+}
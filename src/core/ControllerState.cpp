@@ -0,0 +1,93 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ControllerState.h"
+
+#include <limits>
+
+namespace LisaDeskbridge {
+
+    static constexpr float kUnknown = std::numeric_limits<float>::quiet_NaN();
+
+    ControllerState::ControllerState(){
+        reset();
+    }
+
+    void ControllerState::reset(){
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for(unsigned int i = 0; i < kMaxSourceId; i++){
+            sourcePan[i].store(kUnknown, std::memory_order_relaxed);
+            sourceWidth[i].store(kUnknown, std::memory_order_relaxed);
+            sourceDepth[i].store(kUnknown, std::memory_order_relaxed);
+            sourceElevation[i].store(kUnknown, std::memory_order_relaxed);
+            sourceAuxSend[i].store(kUnknown, std::memory_order_relaxed);
+        }
+
+        masterGain.store(kUnknown, std::memory_order_relaxed);
+        masterFaderPos.store(kUnknown, std::memory_order_relaxed);
+        reverbGain.store(kUnknown, std::memory_order_relaxed);
+        reverbFaderPos.store(kUnknown, std::memory_order_relaxed);
+
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    void ControllerState::write(std::atomic<float> & field, float value){
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        field.store(value, std::memory_order_relaxed);
+
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    ControllerState::Snapshot ControllerState::getSnapshot() const {
+        Snapshot snapshot;
+
+        for(;;){
+            uint64_t before = sequence.load(std::memory_order_acquire);
+
+            if (before & 1){
+                // update in progress
+                continue;
+            }
+
+            for(unsigned int i = 0; i < kMaxSourceId; i++){
+                snapshot.sourcePan[i] = sourcePan[i].load(std::memory_order_relaxed);
+                snapshot.sourceWidth[i] = sourceWidth[i].load(std::memory_order_relaxed);
+                snapshot.sourceDepth[i] = sourceDepth[i].load(std::memory_order_relaxed);
+                snapshot.sourceElevation[i] = sourceElevation[i].load(std::memory_order_relaxed);
+                snapshot.sourceAuxSend[i] = sourceAuxSend[i].load(std::memory_order_relaxed);
+            }
+
+            snapshot.masterGain = masterGain.load(std::memory_order_relaxed);
+            snapshot.masterFaderPos = masterFaderPos.load(std::memory_order_relaxed);
+            snapshot.reverbGain = reverbGain.load(std::memory_order_relaxed);
+            snapshot.reverbFaderPos = reverbFaderPos.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before){
+                snapshot.version = before / 2;
+                return snapshot;
+            }
+        }
+    }
+
+}
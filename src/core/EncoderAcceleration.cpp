@@ -0,0 +1,77 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EncoderAcceleration.h"
+
+namespace LisaDeskbridge {
+
+    static const char * const kParamNames[RelativeParamCount] = {
+            "pan",
+            "width",
+            "distance",
+            "elevation",
+            "pan-spread",
+            "aux-send"
+    };
+
+    const char * EncoderAcceleration::paramName(RelativeParam_t param){
+        if (param < 0 || RelativeParamCount <= param){
+            return nullptr;
+        }
+        return kParamNames[param];
+    }
+
+    EncoderAcceleration::EncoderAcceleration(){
+        for(int i = 0; i < RelativeParamCount; i++){
+            lastTime[i].store(0, std::memory_order_relaxed);
+            lastDirection[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    float EncoderAcceleration::factor(RelativeParam_t param, uint64_t interval) const {
+        float max = curves[param].maxFactor;
+
+        if (kSlowInterval <= interval || max <= 1.0f){
+            return 1.0f;
+        }
+        if (interval <= kFastInterval){
+            return max;
+        }
+
+        float t = (float)(kSlowInterval - interval) / (float)(kSlowInterval - kFastInterval);
+
+        return 1.0f + (max - 1.0f) * t * t;
+    }
+
+    float EncoderAcceleration::step(RelativeParam_t param, int ticks, uint64_t time){
+        int direction = ticks < 0 ? -1 : 1;
+
+        uint64_t last = lastTime[param].exchange(time, std::memory_order_relaxed);
+        int lastDir = lastDirection[param].exchange(direction, std::memory_order_relaxed);
+
+        float f = 1.0f;
+
+        // changing direction always starts slow (as does the first tick)
+        if (last != 0 && last < time && lastDir == direction){
+            f = factor(param, time - last);
+        }
+
+        return (float)ticks * curves[param].stepSize * f;
+    }
+
+}
@@ -0,0 +1,117 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "LastValueCache.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace LisaDeskbridge {
+
+    static constexpr float kUnknown = std::numeric_limits<float>::quiet_NaN();
+
+    LastValueCache::LastValueCache(){
+        for(std::size_t i = 0; i < kCount; i++){
+            values[i].store(kUnknown, std::memory_order_relaxed);
+            updatedAt[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t LastValueCache::now(){
+        // wraps after ~49 days, which only affects the (unsigned) age computation of values that old
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void LastValueCache::setEnabled(bool enable){
+        if (enable && !enabled){
+            // values have not been tracked while disabled
+            invalidateAll();
+        }
+        enabled = enable;
+    }
+
+    void LastValueCache::setEpsilon(float epsilon){
+        assert(epsilon >= 0.0f);
+        this->epsilon = epsilon;
+    }
+
+    void LastValueCache::setMaxAge(unsigned int ms){
+        maxAge = ms;
+    }
+
+    bool LastValueCache::shouldSend(std::size_t index, float value){
+        assert(index < kCount);
+
+        if (!enabled.load(std::memory_order_relaxed)){
+            return true;
+        }
+
+        uint32_t t = now();
+        float last = values[index].load(std::memory_order_relaxed);
+
+        if (!std::isnan(last) && std::fabs(value - last) <= epsilon.load(std::memory_order_relaxed)){
+            uint32_t age = maxAge.load(std::memory_order_relaxed);
+            if (age == 0 || t - updatedAt[index].load(std::memory_order_relaxed) < age){
+                suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        values[index].store(value, std::memory_order_relaxed);
+        updatedAt[index].store(t, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    void LastValueCache::update(std::size_t index, float value){
+        assert(index < kCount);
+
+        values[index].store(value, std::memory_order_relaxed);
+        updatedAt[index].store(now(), std::memory_order_relaxed);
+    }
+
+    void LastValueCache::invalidate(std::size_t index){
+        assert(index < kCount);
+
+        values[index].store(kUnknown, std::memory_order_relaxed);
+    }
+
+    void LastValueCache::invalidateRange(std::size_t from, std::size_t to){
+        for(std::size_t i = from; i < to; i++){
+            values[i].store(kUnknown, std::memory_order_relaxed);
+        }
+    }
+
+    void LastValueCache::invalidateSources(){
+        invalidateRange(kSourceOffset, kCount);
+    }
+
+    void LastValueCache::invalidateSourceParam(SourceValue_t param){
+        for(std::size_t i = kSourceOffset + param; i < kCount; i += SourceValueCount){
+            values[i].store(kUnknown, std::memory_order_relaxed);
+        }
+    }
+
+    void LastValueCache::invalidateAll(){
+        invalidateRange(0, kCount);
+    }
+
+}
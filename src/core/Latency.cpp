@@ -0,0 +1,122 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Latency.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace LisaDeskbridge {
+
+    thread_local uint64_t currentIngress = 0;
+
+    const char * latencySourceName(LatencySource_t source){
+        switch(source){
+            case LatencySourceMidi:
+                return "MIDI";
+            case LatencySourceMixer:
+                return "Mixer";
+            default:
+                return "?";
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram(){
+        for(unsigned int i = 0; i < kBucketCount; i++){
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    unsigned int LatencyHistogram::indexOf(uint64_t value){
+        if (value < kSubBucketCount){
+            return (unsigned int)value;
+        }
+
+        unsigned int exponent = 63 - __builtin_clzll(value);
+        unsigned int sub = (unsigned int)(value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+
+        return (exponent - kSubBucketBits + 1) * kSubBucketCount + sub;
+    }
+
+    uint64_t LatencyHistogram::valueAt(unsigned int index){
+        if (index < kSubBucketCount){
+            return index;
+        }
+
+        unsigned int exponent = index / kSubBucketCount + kSubBucketBits - 1;
+        uint64_t sub = index % kSubBucketCount;
+        unsigned int shift = exponent - kSubBucketBits;
+
+        return ((kSubBucketCount + sub + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t ns){
+        counts[indexOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = maxValue.load(std::memory_order_relaxed);
+        while(max < ns && !maxValue.compare_exchange_weak(max, ns, std::memory_order_relaxed)){
+            // retry with updated max
+        }
+    }
+
+    uint64_t LatencyHistogram::percentile(double fraction) const {
+        assert(0.0 <= fraction && fraction <= 1.0);
+
+        uint64_t n = count();
+        if (n == 0){
+            return 0;
+        }
+
+        uint64_t rank = (uint64_t)std::ceil(fraction * (double)n);
+        if (rank == 0){
+            rank = 1;
+        }
+
+        uint64_t sum = 0;
+        for(unsigned int i = 0; i < kBucketCount; i++){
+            sum += counts[i].load(std::memory_order_relaxed);
+            if (sum >= rank){
+                // never report more than was actually seen
+                uint64_t value = valueAt(i);
+                uint64_t m = max();
+                return value < m ? value : m;
+            }
+        }
+
+        return max();
+    }
+
+    LatencyHistogram::Summary LatencyHistogram::summarize() const {
+        return {
+            .count = count(),
+            .p50 = percentile(0.5),
+            .p99 = percentile(0.99),
+            .max = max()
+        };
+    }
+
+    void LatencyHistogram::reset(){
+        for(unsigned int i = 0; i < kBucketCount; i++){
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+
+}
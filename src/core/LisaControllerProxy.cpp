@@ -17,6 +17,7 @@
 */
 
 #include <iostream>
+#include <stdexcept>
 
 #include "LisaControllerProxy.h"
 #include "LisaController.h"
@@ -24,41 +25,145 @@
 #include "log.h"
 
 #include "osc/OscReceivedElements.h"
-#include "osc/OscOutboundPacketStream.h"
 
-#ifndef OUTPUT_BUFFER_SIZE
-#define OUTPUT_BUFFER_SIZE 512
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
 #endif
 
 
 namespace LisaDeskbridge {
 
-    void LisaControllerProxy::start(unsigned short listenPort, std::string & controllerAddress, unsigned short controllerPort){
-                if (mIsRunning){
+    void LisaControllerProxy::start(unsigned short listenPort, std::string & controllerAddress, unsigned short controllerPort, Reactor * reactor){
+        start(listenPort, std::vector<ControllerAddress>{{controllerAddress, controllerPort}}, reactor);
+    }
+
+    void LisaControllerProxy::start(unsigned short listenPort, const std::vector<ControllerAddress> & controllers, Reactor * reactor){
+        if (mIsRunning){
             return;
         }
 
-        log(LogLevelInfo, "Listening for L-ISA Controller messages on port %d", listenPort);
+        if (controllers.empty() || controllers.size() > kMaxControllers){
+            throw std::invalid_argument("Invalid number of L-ISA Controllers");
+        }
+
+        // nothing is known about the controller's state yet
+        valueCache.invalidateAll();
+        state.reset();
+
+        // set up everything the receiver reads before it starts
+        controllerCount = 0;
+        for(const ControllerAddress & controller : controllers){
+            Controller & c = this->controllers[controllerCount++];
+            c.name = controller.address + ":" + std::to_string(controller.port);
+            c.address = IpEndpointName(controller.address.data(), controller.port).address;
+            c.port = controller.port;
+            c.pingSentAt = 0;
+            c.pongReceivedAt = 0;
+        }
+        activeController = 0;
+
+        if (controllerCount == 1){
+            transport = new UdpTransport(controllers[0].address.data(), controllers[0].port);
+        } else {
+            UdpFanoutTransport * fanout = new UdpFanoutTransport();
+            for(const ControllerAddress & controller : controllers){
+                if (!fanout->addTarget(controller.address.data(), controller.port)){
+                    delete fanout;
+                    throw std::invalid_argument("Invalid L-ISA Controller address");
+                }
+            }
+            transport = fanout;
+        }
+        ownsTransport = true;
+
+        for(unsigned int i = 0; i < controllerCount; i++){
+            LISA_LOG(LogLevelInfo, "Sending to L-ISA Controller on host %s", this->controllers[i].name.data());
+        }
+
+        LISA_LOG(LogLevelInfo, "Listening for L-ISA Controller messages on port %d", listenPort);
+
+        this->reactor = reactor;
+
+#if defined(__linux__)
+        if (!openRxSocket(listenPort)){
+            abortStart();
+            throw std::runtime_error("Could not open UDP receive socket");
+        }
+#else
+        if (reactor != nullptr){
+            if (!openRxSocket(listenPort)){
+                abortStart();
+                throw std::runtime_error("Could not open UDP receive socket");
+            }
+        } else {
+            try {
+                udpListeningReceiveSocket = new UdpListeningReceiveSocket(
+                        IpEndpointName( IpEndpointName::ANY_ADDRESS, listenPort),
+                        this
+                );
+            } catch (...){
+                abortStart();
+                throw;
+            }
+        }
+#endif
+
+        startTx();
+
+        // receive last, the RX thread reads the controllers and the transport
+#if defined(__linux__)
+        if (reactor == nullptr){
+            thread = new std::thread([this](){
+                rxRun();
+            });
+        }
+#else
+        if (udpListeningReceiveSocket != nullptr){
+            thread = new std::thread([](UdpListeningReceiveSocket * socket){
+                socket->Run();
+            }, udpListeningReceiveSocket);
+        }
+#endif
+
+        mIsRunning = true;
+
+        startRelativeCoalescing();
+    }
+
+    void LisaControllerProxy::abortStart(){
+        closeRxSocket();
 
-//        try {
-            udpListeningReceiveSocket = new UdpListeningReceiveSocket(
-                    IpEndpointName( IpEndpointName::ANY_ADDRESS, listenPort),
-                    this
-            );
-//        } catch (std::exception &e){
-////            logError("Could not create UDP receive socket");
-////            throw e;
-//        }
+        delete transport;
+        transport = nullptr;
+        ownsTransport = false;
+
+        controllerCount = 0;
+        reactor = nullptr;
+    }
+
+    void LisaControllerProxy::startDetached(Transport & transport){
+        if (mIsRunning){
+            return;
+        }
 
-        thread = new std::thread([](UdpListeningReceiveSocket * socket){
-            socket->Run();
-        }, udpListeningReceiveSocket);
+        valueCache.invalidateAll();
+        state.reset();
 
-        log(LogLevelInfo, "Sending to L-ISA Controller on host %s:%d", controllerAddress.data(), controllerPort);
+        this->transport = &transport;
+        ownsTransport = false;
 
-        udpTransmitSocket = new UdpTransmitSocket( IpEndpointName( controllerAddress.data(), controllerPort ) );
+        startTx();
 
         mIsRunning = true;
+
+        startRelativeCoalescing();
     }
 
     void LisaControllerProxy::stop(){
@@ -66,112 +171,773 @@ namespace LisaDeskbridge {
             return;
         }
 
-        udpListeningReceiveSocket->AsynchronousBreak();
-        thread->join();
+        stopRelativeCoalescing();
+
+        closeRxSocket();
+
+        // not started detached (or on a reactor)
+        if (udpListeningReceiveSocket != nullptr){
+            udpListeningReceiveSocket->AsynchronousBreak();
+            thread->join();
+
+            delete udpListeningReceiveSocket;
+            udpListeningReceiveSocket = nullptr;
+            delete thread;
+            thread = nullptr;
+        }
+
+        stopTx();
+
+        LISA_LOG(LogLevelInfo, "Sent %llu datagrams to L-ISA Controller in %llu system calls (%llu dropped)",
+            (unsigned long long)txSent.load(), (unsigned long long)txSyscalls.load(), (unsigned long long)txDropped.load());
 
-        delete udpTransmitSocket;
-        delete udpListeningReceiveSocket;
-        delete thread;
+        if (ownsTransport){
+            delete transport;
+        }
+        transport = nullptr;
+
+        reactor = nullptr;
 
         mIsRunning = false;
     }
 
-    void LisaControllerProxy::ProcessMessage( const osc::ReceivedMessage& m,
-                                 const IpEndpointName& remoteEndpoint ) {
-        (void) remoteEndpoint; // suppress unused parameter warning
+    bool LisaControllerProxy::openRxSocket(unsigned short listenPort){
+        rxSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (rxSocket == -1){
+            return false;
+        }
 
+#if defined(__linux__)
+        // to wake rxRun()
+        if (reactor == nullptr){
+            rxStopFd = eventfd(0, EFD_CLOEXEC);
+            if (rxStopFd == -1){
+                ::close(rxSocket);
+                rxSocket = -1;
+                return false;
+            }
+        }
+#endif
 
-        try{
-            // example of parsing single messages. osc::OsckPacketListener
-            // handles the bundle traversal.
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(listenPort);
 
-            log(LogLevelDebug, "LisaControllerProxy received: %s", m.AddressPattern());
+        if (fcntl(rxSocket, F_SETFL, fcntl(rxSocket, F_GETFL) | O_NONBLOCK) == -1 ||
+            bind(rxSocket, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+            (reactor != nullptr && !reactor->watch(rxSocket, [this](){ receiveAll(); }))){
+            LISA_LOG(LogLevelError, "Could not listen on port %d: %s", listenPort, strerror(errno));
+            closeRxSocket();
+            return false;
+        }
 
-            osc::ReceivedMessage::const_iterator args = m.ArgumentsBegin();
+        return true;
+    }
 
-            SourceId_t src = 0;
-            int  n = 0;
+    void LisaControllerProxy::closeRxSocket(){
+        if (rxStopFd != -1){
+            uint64_t one = 1;
+            if (write(rxStopFd, &one, sizeof(one)) != sizeof(one)){
+                LISA_LOG(LogLevelError, "Could not stop receiving: %s", strerror(errno));
+            }
+        }
+
+        if (thread != nullptr && udpListeningReceiveSocket == nullptr){
+            thread->join();
+            delete thread;
+            thread = nullptr;
+        }
+
+        if (rxStopFd != -1){
+            ::close(rxStopFd);
+            rxStopFd = -1;
+        }
+
+        if (rxSocket != -1){
+            if (reactor != nullptr){
+                reactor->unwatch(rxSocket);
+            }
+            ::close(rxSocket);
+            rxSocket = -1;
+        }
+    }
+
+    void LisaControllerProxy::rxRun(){
+#if defined(__linux__)
+        struct pollfd fds[2] = {
+                {rxSocket, POLLIN, 0},
+                {rxStopFd, POLLIN, 0}
+        };
+
+        for(;;){
+            if (poll(fds, 2, -1) == -1){
+                if (errno == EINTR){
+                    continue;
+                }
+                LISA_LOG(LogLevelError, "poll failed: %s", strerror(errno));
+                return;
+            }
+            if (fds[1].revents != 0){
+                return;
+            }
+            if (fds[0].revents != 0){
+                receiveAll();
+            }
+        }
+#endif
+    }
+
+    void LisaControllerProxy::receiveAll(){
+#if defined(__linux__)
+        struct iovec iovs[kRxBatchSize];
+        struct sockaddr_in from[kRxBatchSize];
+        struct mmsghdr msgs[kRxBatchSize];
+
+        for(;;){
+            for(std::size_t i = 0; i < kRxBatchSize; i++){
+                iovs[i].iov_base = rxBuffers[i];
+                iovs[i].iov_len = kRxDatagramSize;
+                std::memset(&msgs[i], 0, sizeof(msgs[i]));
+                msgs[i].msg_hdr.msg_name = &from[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            int count = recvmmsg(rxSocket, msgs, kRxBatchSize, MSG_DONTWAIT, nullptr);
+            if (count <= 0){
+                // EAGAIN: drained
+                return;
+            }
 
-            if( std::strcmp( m.AddressPattern(), kMsgRxMasterGain ) == 0 ){
-                float gain = (args++)->AsFloat();
-                iDelegate->receivedMasterGain(gain);
+            metrics.oscRxBatches.increment();
+            metrics.oscRxDatagrams.add(count);
+
+            beginRxBatch();
+            for(int i = 0; i < count; i++){
+                try {
+                    ProcessPacket(rxBuffers[i], (int)msgs[i].msg_len,
+                                  IpEndpointName(ntohl(from[i].sin_addr.s_addr), ntohs(from[i].sin_port)));
+                } catch (osc::Exception & e){
+                    // malformed packet (messages are taken care of by ProcessMessage())
+                    metrics.oscRxParseErrors.increment();
+                }
             }
-            else if( std::strcmp( m.AddressPattern(), kMsgRxMasterFaderPos ) == 0 ){
-                float pos = (args++)->AsFloat();
-                iDelegate->receivedMasterFaderPos(pos);
+            endRxBatch();
+
+            if (count < (int)kRxBatchSize){
+                return;
             }
-            else if( std::strcmp( m.AddressPattern(), kMsgRxReverbGain ) == 0 ){
-                float gain = (args++)->AsFloat();
-                iDelegate->receivedReverbGain(gain);
+        }
+#else
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+
+        for(;;){
+            ssize_t size = recvfrom(rxSocket, rxBuffers[0], kRxDatagramSize, 0, (struct sockaddr*)&from, &fromLen);
+            if (size <= 0){
+                // EAGAIN: drained
+                return;
+            }
+
+            metrics.oscRxBatches.increment();
+            metrics.oscRxDatagrams.increment();
+
+            ProcessPacket(rxBuffers[0], (int)size, IpEndpointName(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port)));
+
+            fromLen = sizeof(from);
+        }
+#endif
+    }
+
+    void LisaControllerProxy::beginRxBatch(){
+        rxCoalescing = true;
+    }
+
+    void LisaControllerProxy::endRxBatch(){
+        rxCoalescing = false;
+
+        for(std::size_t i = 0; i < rxOrderCount; i++){
+            RxAddress & address = rxOrder[i];
+            RxLatest & latest = rxLatest[address.type][address.id];
+
+            latest.pending = false;
+
+            (this->*kRxHandlers[address.type])(address.id, latest.value);
+        }
+
+        rxOrderCount = 0;
+    }
+
+    void LisaControllerProxy::startTx(){
+#if defined(__linux__)
+        // on a reactor, its thread sends whenever woken through the eventfd
+        if (reactor != nullptr){
+            txWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (txWakeFd != -1 && reactor->watch(txWakeFd, [this](){
+                    uint64_t count;
+                    if (read(txWakeFd, &count, sizeof(count)) != sizeof(count)){
+                        // spurious wakeup
+                    }
+                    drainTx();
+                })){
+                return;
             }
-            else if( std::strcmp( m.AddressPattern(), kMsgRxReverbFaderPos ) == 0 ){
-                float pos = (args++)->AsFloat();
-                iDelegate->receivedReverbFaderPos(pos);
+
+            LISA_LOG(LogLevelError, "Could not send on event loop, using a TX thread: %s", strerror(errno));
+            if (txWakeFd != -1){
+                ::close(txWakeFd);
+                txWakeFd = -1;
             }
-            else if (sscanf(m.AddressPattern(), kMsgRxSourcePan, &src, &n) == 1 && n > 0){
-                float pan = (args++)->AsFloat();
-                iDelegate->receivedSourcePan(src, pan);
+        }
+#endif
+
+        txStopRequested = false;
+        txThread = new std::thread([this](){
+            txRun();
+        });
+    }
+
+    void LisaControllerProxy::stopTx(){
+#if defined(__linux__)
+        if (txWakeFd != -1){
+            reactor->unwatch(txWakeFd);
+            ::close(txWakeFd);
+            txWakeFd = -1;
+
+            // whatever is still queued
+            drainTx();
+            return;
+        }
+#endif
+
+        // the TX thread sends whatever is still queued before terminating
+        {
+            std::lock_guard<std::mutex> lock(txMutex);
+            txStopRequested = true;
+        }
+        txCv.notify_one();
+        txThread->join();
+
+        delete txThread;
+        txThread = nullptr;
+    }
+
+    void LisaControllerProxy::ProcessPacket( const char * data, int size, const IpEndpointName& remoteEndpoint ){
+        capture(CaptureOscRx, 0, data, size);
+
+        osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+    }
+
+    int LisaControllerProxy::controllerOf(const IpEndpointName & endpoint){
+        if (controllerCount <= 1){
+            return 0;
+        }
+        int match = -1;
+        for(unsigned int i = 0; i < controllerCount; i++){
+            if (controllers[i].address == endpoint.address){
+                if (controllers[i].port == endpoint.port){
+                    return (int)i;
+                }
+                if (match == -1){
+                    match = (int)i;
+                }
             }
-            else if (sscanf(m.AddressPattern(), kMsgRxSourceWidth, &src, &n) == 1 && n > 0){
-                float width = (args++)->AsFloat();
-                iDelegate->receivedSourceWidth(src, width);
+        }
+        return match;
+    }
+
+    void LisaControllerProxy::ProcessMessage( const osc::ReceivedMessage& m,
+                                 const IpEndpointName& remoteEndpoint ) {
+
+        try{
+            // example of parsing single messages. osc::OsckPacketListener
+            // handles the bundle traversal.
+
+            LISA_LOG(LogLevelDebug, "LisaControllerProxy received: %s", m.AddressPattern());
+
+            if (stateResetRequested.load(std::memory_order_relaxed) && stateResetRequested.exchange(false, std::memory_order_acquire)){
+                state.reset();
             }
-            else if (sscanf(m.AddressPattern(), kMsgRxSourceDistance, &src, &n) == 1 && n > 0){
-                float distance = (args++)->AsFloat();
-                iDelegate->receivedSourceDepth(src, distance);
+
+            RxAddress address = parseRxAddress(m.AddressPattern());
+
+            metrics.oscRxMessages[classifyRxAddress(address.type)].increment();
+
+            if (address.type == RxAddressUnknown || (address.type >= RxAddressSourcePan && !isValidSourceId(address.id))){
+                LISA_LOG(LogLevelDebug, "LisaControllerProxy: Received unknown packet: %s",m.AddressPattern() );
+                return;
             }
-            else if (sscanf(m.AddressPattern(), kMsgRxSourceElevation, &src, &n) == 1 && n > 0){
-                float elevation = (args++)->AsFloat();
-                iDelegate->receivedSourceElevation(src, elevation);
+
+            int controller = controllerOf(remoteEndpoint);
+
+            // the only message without a value, and taken from any controller (to know which are alive)
+            if (address.type == RxAddressPong){
+                if (controller != -1){
+                    receivedPong((unsigned int)controller);
+                }
+                return;
             }
-            else if (sscanf(m.AddressPattern(), kMsgRxSourceAuxSend, &src, &n) == 1 && n > 0){
-                float send = (args++)->AsFloat();
-                iDelegate->receivedSourceAuxSend(src, send);
+
+            if (controller != (int)activeController.load(std::memory_order_acquire)){
+                metrics.oscRxIgnored.increment();
+                return;
             }
-            else {
 
-                log(LogLevelDebug, "LisaControllerProxy: Received unknown packet: %s",m.AddressPattern() );
+            osc::ReceivedMessage::const_iterator args = m.ArgumentsBegin();
+            float value = (args++)->AsFloat();
+
+            if (rxCoalescing){
+                RxLatest & latest = rxLatest[address.type][address.id];
+                if (latest.pending){
+                    metrics.oscRxCoalesced.increment();
+                } else {
+                    latest.pending = true;
+                    rxOrder[rxOrderCount++] = address;
+                }
+                latest.value = value;
+                return;
             }
+
+            (this->*kRxHandlers[address.type])(address.id, value);
         } catch( osc::Exception& e ){
             // any parsing errors such as unexpected argument types, or
             // missing arguments get thrown as exceptions.
-            log(LogLevelError,"LisaControllerProxy: parsing message for address '%s': %s", m.AddressPattern(), e.what());
+            metrics.oscRxParseErrors.increment();
+            LISA_LOG(LogLevelError,"LisaControllerProxy: parsing message for address '%s': %s", m.AddressPattern(), e.what());
         }
     }
 
-    void LisaControllerProxy::sendToController(const char *address, int count, ...) {
-        assert(address != nullptr);
+    const LisaControllerProxy::RxHandler LisaControllerProxy::kRxHandlers[RxAddressCount] = {
+            nullptr, // RxAddressUnknown
+            &LisaControllerProxy::receivedMasterGain,
+            &LisaControllerProxy::receivedMasterFaderPos,
+            &LisaControllerProxy::receivedReverbGain,
+            &LisaControllerProxy::receivedReverbFaderPos,
+            nullptr, // RxAddressPong, see ProcessMessage()
+            &LisaControllerProxy::receivedSourcePan,
+            &LisaControllerProxy::receivedSourceWidth,
+            &LisaControllerProxy::receivedSourceDistance,
+            &LisaControllerProxy::receivedSourceElevation,
+            &LisaControllerProxy::receivedSourceAuxSend
+    };
 
-        char buffer[OUTPUT_BUFFER_SIZE];
-        osc::OutboundPacketStream msg( buffer, OUTPUT_BUFFER_SIZE );
+    void LisaControllerProxy::receivedMasterGain(unsigned int, float gain){
+        state.setMasterGain(gain);
+        valueCache.update(LastValueCache::faderIndex(FaderValueMasterGain), gain);
+        iDelegate->receivedMasterGain(gain);
+    }
 
-        msg << osc::BeginMessage( address );
+    void LisaControllerProxy::receivedMasterFaderPos(unsigned int, float pos){
+        state.setMasterFaderPos(pos);
+        valueCache.update(LastValueCache::faderIndex(FaderValueMasterPos), pos);
+        iDelegate->receivedMasterFaderPos(pos);
+    }
 
-        va_list args;
-        va_start(args, count);
-        for (int i = 0; i < count; i+=2)
-        {
-            enum arg_t type = va_arg(args, arg_t);
-             if (type == INT_T){
-                int i = va_arg(args, int);
-                msg << i;
-            } else if (type == FLOAT_T){
-                float d = va_arg(args, double);
-                msg << d;
-            } else if (type == STRING_T) {
-                char * str = va_arg(args, char* );
-                msg << str;
+    void LisaControllerProxy::receivedReverbGain(unsigned int, float gain){
+        state.setReverbGain(gain);
+        valueCache.update(LastValueCache::faderIndex(FaderValueReverbGain), gain);
+        iDelegate->receivedReverbGain(gain);
+    }
+
+    void LisaControllerProxy::receivedReverbFaderPos(unsigned int, float pos){
+        state.setReverbFaderPos(pos);
+        valueCache.update(LastValueCache::faderIndex(FaderValueReverbPos), pos);
+        iDelegate->receivedReverbFaderPos(pos);
+    }
+
+    void LisaControllerProxy::receivedPong(unsigned int controller){
+        Controller & c = controllers[controller];
+
+        uint64_t now = latencyNow();
+        uint64_t sent = c.pingSentAt.exchange(0, std::memory_order_acq_rel);
+        uint64_t rtt = 0;
+
+        if (sent != 0 && sent <= now){
+            rtt = now - sent;
+            if (controller == activeController.load(std::memory_order_acquire)){
+                pingRtt.record(rtt);
+            }
+        }
+
+        c.pongReceivedAt.store(now, std::memory_order_release);
+
+        iDelegate->receivedPong(controller, rtt);
+    }
+
+    void LisaControllerProxy::receivedSourcePan(unsigned int src, float pan){
+        state.setSourcePan(src, pan);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValuePan), pan);
+        iDelegate->receivedSourcePan(src, pan);
+    }
+
+    void LisaControllerProxy::receivedSourceWidth(unsigned int src, float width){
+        state.setSourceWidth(src, width);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueWidth), width);
+        iDelegate->receivedSourceWidth(src, width);
+    }
+
+    void LisaControllerProxy::receivedSourceDistance(unsigned int src, float distance){
+        state.setSourceDepth(src, distance);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueDistance), distance);
+        iDelegate->receivedSourceDepth(src, distance);
+    }
+
+    void LisaControllerProxy::receivedSourceElevation(unsigned int src, float elevation){
+        state.setSourceElevation(src, elevation);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueElevation), elevation);
+        iDelegate->receivedSourceElevation(src, elevation);
+    }
+
+    void LisaControllerProxy::receivedSourceAuxSend(unsigned int src, float send){
+        state.setSourceAuxSend(src, send);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueAuxSend), send);
+        iDelegate->receivedSourceAuxSend(src, send);
+    }
+
+    osc::OutboundPacketStream & LisaControllerProxy::txStream(){
+        // one encoding buffer per thread, so concurrent senders (MIDI, mixer and OSC receive threads) do not interfere
+        static thread_local char buffer[OUTPUT_BUFFER_SIZE];
+        static thread_local osc::OutboundPacketStream stream( buffer, OUTPUT_BUFFER_SIZE );
+        return stream;
+    }
+
+    LisaControllerProxy::Bundle & LisaControllerProxy::txBundle(){
+        static thread_local Bundle bundle;
+        return bundle;
+    }
+
+    void LisaControllerProxy::transmit(const char * data, std::size_t size) {
+
+        if (size > kOscMaxDatagramSize){
+            txDropped.fetch_add(1, std::memory_order_relaxed);
+            LISA_LOG(LogLevelError, "Not sending oversized datagram (%d bytes)", (int)size);
+            return;
+        }
+
+        bool queued = txQueue.push([data,size](Datagram & datagram){
+            datagram.ingress = currentIngress;
+            datagram.size = size;
+            std::memcpy(datagram.data, data, size);
+        });
+
+        if (!queued){
+            txDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        txPushed.fetch_add(1, std::memory_order_relaxed);
+
+        TxDefer & defer = txDefer();
+        if (defer.depth > 0 && (defer.pending == nullptr || defer.pending == this)){
+            defer.pending = this;
+            return;
+        }
+
+        wakeTx();
+    }
+
+    void LisaControllerProxy::wakeTx(){
+#if defined(__linux__)
+        if (txWakeFd != -1){
+            uint64_t one = 1;
+            if (write(txWakeFd, &one, sizeof(one)) != sizeof(one)){
+                // counter saturated, ie. a wakeup is pending anyway
+            }
+            return;
+        }
+#endif
+
+        // pairs with the fence in txRun(): either we see the TX thread going to sleep or it sees our datagram
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (txSleeping.load(std::memory_order_relaxed)){
+            std::lock_guard<std::mutex> lock(txMutex);
+            txCv.notify_one();
+        }
+    }
+
+    LisaControllerProxy::TxDefer & LisaControllerProxy::txDefer(){
+        static thread_local TxDefer defer;
+        return defer;
+    }
+
+    void LisaControllerProxy::endTxBatch(){
+        TxDefer & defer = txDefer();
+
+        assert(defer.depth > 0);
+
+        if (--defer.depth > 0 || defer.pending == nullptr){
+            return;
+        }
+
+        LisaControllerProxy * proxy = defer.pending;
+        defer.pending = nullptr;
+
+        proxy->wakeTx();
+    }
+
+    void LisaControllerProxy::drainTx(){
+        std::size_t count;
+        while((count = popTxBatch()) > 0){
+            sendTxBatch(count);
+        }
+    }
+
+    void LisaControllerProxy::txRun(){
+
+        for(;;){
+
+            drainTx();
+
+            std::unique_lock<std::mutex> lock(txMutex);
+
+            txSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (txQueue.empty()){
+                if (txStopRequested){
+                    txSleeping.store(false, std::memory_order_relaxed);
+                    return;
+                }
+                txCv.wait(lock, [this](){
+                    return txStopRequested || !txQueue.empty();
+                });
+            }
+
+            txSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t LisaControllerProxy::popTxBatch(){
+        std::size_t count = 0;
+
+        // queue slots are only valid during pop(), hence the copy
+        while(count < kTxBatchSize && txQueue.pop([this, count](Datagram & datagram){
+            Datagram & batched = txBatch[count];
+            batched.ingress = datagram.ingress;
+            batched.size = datagram.size;
+            std::memcpy(batched.data, datagram.data, datagram.size);
+        })){
+            count++;
+        }
+
+        return count;
+    }
+
+    void LisaControllerProxy::sendTxBatch(std::size_t count){
+        Transport::Buffer buffers[kTxBatchSize];
+
+        for(std::size_t i = 0; i < count; i++){
+            buffers[i] = {txBatch[i].data, txBatch[i].size};
+        }
+
+        txSyscalls.fetch_add(transport->sendBatch(buffers, count), std::memory_order_relaxed);
+        txSent.fetch_add(count, std::memory_order_relaxed);
+
+        uint64_t now = latencyNow();
+
+        for(std::size_t i = 0; i < count; i++){
+            Datagram & datagram = txBatch[i];
+
+            capture(CaptureOscTx, 0, datagram.data, datagram.size);
+
+            if (datagram.ingress != 0){
+                latency[ingressSource(datagram.ingress)].record(now - ingressTime(datagram.ingress));
+            }
+
+            // an OSC message starts with its (null terminated) address
+            if (datagram.data[0] == '/'){
+                LISA_LOG(LogLevelDebug, "sendToController: %s", datagram.data);
+            } else {
+                LISA_LOG(LogLevelDebug, "sendToController: bundle (%d bytes)", (int)datagram.size);
+            }
+        }
+    }
+
+    LisaControllerProxy::TxStats LisaControllerProxy::getTxStats(){
+        return {
+            .depth = txQueue.size(),
+            .pushed = txPushed.load(std::memory_order_relaxed),
+            .dropped = txDropped.load(std::memory_order_relaxed),
+            .sent = txSent.load(std::memory_order_relaxed),
+            .syscalls = txSyscalls.load(std::memory_order_relaxed)
+        };
+    }
+
+    void LisaControllerProxy::beginBundle(){
+        Bundle & bundle = txBundle();
+
+        assert(bundle.owner == nullptr || bundle.owner == this);
+
+        if (bundle.depth++ > 0){
+            return;
+        }
+
+        bundle.owner = this;
+        bundle.messageCount = 0;
+        bundle.stream.Clear();
+        bundle.stream << osc::BeginBundleImmediate;
+    }
+
+    void LisaControllerProxy::endBundle(){
+        Bundle & bundle = txBundle();
+
+        assert(bundle.owner == this);
+        assert(bundle.depth > 0);
+
+        if (--bundle.depth > 0){
+            return;
+        }
+
+        transmitBundle(bundle);
+
+        bundle.owner = nullptr;
+    }
+
+    void LisaControllerProxy::transmitBundle(Bundle & bundle){
+
+        // "#bundle" + time tag + size of first element
+        static constexpr std::size_t kSingleMessageOffset = 8 + 8 + 4;
+
+        if (bundle.messageCount == 0){
+            return;
+        }
+
+        // the proxy might have been stopped in the meantime
+        if (isRunning()){
+            if (bundle.messageCount == 1){
+                // no need to wrap a single message
+                transmit(bundle.stream.Data() + kSingleMessageOffset, bundle.stream.Size() - kSingleMessageOffset);
             } else {
-                 assert(false); // should not happen ...
+                bundle.stream << osc::EndBundle;
+
+                transmit(bundle.stream.Data(), bundle.stream.Size());
             }
         }
-        va_end(args);
 
-        msg << osc::EndMessage;
+        bundle.messageCount = 0;
+        bundle.stream.Clear();
+        bundle.stream << osc::BeginBundleImmediate;
+    }
+
+    // Relative changes
+
+    static constexpr const char * kSelectedSourcesRelativeAddresses[RelativeParamCount] = {
+            kMsgSetSelectedSourcesRelativePan,
+            kMsgSetSelectedSourcesRelativeWidth,
+            kMsgSetSelectedSourcesRelativeDistance,
+            kMsgSetSelectedSourcesRelativeElevation,
+            kMsgSetSelectedSourcesRelativePanSpread,
+            nullptr // there is no relative aux send for selected sources
+    };
+
+    static constexpr SourceAddress_t kSourceRelativeAddresses[RelativeParamCount] = {
+            SourceAddressRelativePan,
+            SourceAddressRelativeWidth,
+            SourceAddressRelativeDistance,
+            SourceAddressRelativeElevation,
+            SourceAddressRelativePanSpread,
+            SourceAddressRelativeAuxSend
+    };
+
+    static constexpr GroupAddress_t kGroupRelativeAddresses[RelativeParamCount] = {
+            GroupAddressRelativePan,
+            GroupAddressRelativeWidth,
+            GroupAddressRelativeDistance,
+            GroupAddressRelativeElevation,
+            GroupAddressRelativePanSpread,
+            GroupAddressRelativeAuxSend
+    };
+
+    void LisaControllerProxy::setRelativeFlushRate(unsigned int hz){
+        assert(hz <= kRelativeFlushRateMax);
+
+        relativeFlushRate = hz;
+
+        if (isRunning()){
+            stopRelativeCoalescing();
+            startRelativeCoalescing();
+        }
+    }
+
+    void LisaControllerProxy::startRelativeCoalescing(){
+        if (relativeFlushRate == 0){
+            return;
+        }
+
+        if (reactor != nullptr){
+            relativeFlushTimer = reactor->addTimer(std::chrono::microseconds(1000000 / relativeFlushRate), [this](){
+                flushRelative();
+            });
+        } else {
+            relativeFlushTask.start(std::chrono::microseconds(1000000 / relativeFlushRate), [this](){
+                flushRelative();
+            });
+        }
+
+        relativeCoalescing = true;
+    }
+
+    void LisaControllerProxy::stopRelativeCoalescing(){
+        relativeCoalescing = false;
+
+        relativeFlushTask.stop();
+
+        if (relativeFlushTimer != -1){
+            reactor->removeTimer(relativeFlushTimer);
+            relativeFlushTimer = -1;
+        }
+
+        // send anything left over
+        flushRelative();
+    }
+
+    void LisaControllerProxy::flushRelative(){
+        TxBatchScope batch;
+
+        relativeCoalescer.flush([this](RelativeTarget_t target, unsigned int id, RelativeParam_t param, float value, uint64_t ingressTag){
+            // attribute the message to the (first) input that caused it
+            IngressScope ingress(ingressTag != 0 ? ingressTag : currentIngress);
+
+            sendRelativeNow(target, id, param, value);
+        });
+    }
+
+    void LisaControllerProxy::sendRelative(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float value){
+        metrics.relativeChanges.increment();
+
+        if (relativeCoalescing){
+            relativeCoalescer.add(target, id, param, value, currentIngress);
+        } else {
+            sendRelativeNow(target, id, param, value);
+        }
+    }
+
+    void LisaControllerProxy::sendRelativeNow(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float value){
+        static_assert((int)RelativeAuxSend == (int)SourceValueAuxSend && (int)RelativeParamCount == (int)SourceValueCount);
+
+        metrics.relativeMessages.increment();
 
-        udpTransmitSocket->Send(msg.Data(), msg.Size());
+        // the resulting absolute value(s) are unknown
+        if (target == RelativeTargetSource){
+            valueCache.invalidate(LastValueCache::sourceIndex(id, (SourceValue_t)param));
+        } else {
+            valueCache.invalidateSourceParam((SourceValue_t)param);
+        }
 
-        log(LogLevelDebug, "sendToController: %s", address);
+        if (target == RelativeTargetSelectedSources){
+            assert(kSelectedSourcesRelativeAddresses[param] != nullptr);
+            send(MessageClassSourceParam, kSelectedSourcesRelativeAddresses[param], value);
+        }
+        else if (target == RelativeTargetSource){
+            send(MessageClassSourceParam, oscAddresses.source(id, kSourceRelativeAddresses[param]).str, value);
+        }
+        else if (target == RelativeTargetGroup){
+            send(MessageClassGroupParam, oscAddresses.group(id, kGroupRelativeAddresses[param]).str, value);
+        }
     }
 
     // Source control flags
@@ -183,10 +949,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidControlFlag(flag));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceControlPan, src);
-
-        sendToController(msg,1, STRING_T, kControlFlags[flag]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressControlPan).str, kControlFlags[flag]);
     }
     void LisaControllerProxy::setSourceControlFlagWidth(SourceId_t src, ControlFlag_t flag){
         if (!isRunning()){
@@ -195,10 +958,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidControlFlag(flag));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceControlWidth, src);
-
-        sendToController(msg,1, STRING_T, kControlFlags[flag]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressControlWidth).str, kControlFlags[flag]);
     }
     void LisaControllerProxy::setSourceControlFlagDistance(SourceId_t src, ControlFlag_t flag){
         if (!isRunning()){
@@ -207,10 +967,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidControlFlag(flag));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceControlDistance, src);
-
-        sendToController(msg,1, STRING_T, kControlFlags[flag]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressControlDistance).str, kControlFlags[flag]);
     }
     void LisaControllerProxy::setSourceControlFlagElevation(SourceId_t src, ControlFlag_t flag){
         if (!isRunning()){
@@ -219,10 +976,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidControlFlag(flag));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceControlElevation, src);
-
-        sendToController(msg,1, STRING_T, kControlFlags[flag]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressControlElevation).str, kControlFlags[flag]);
     }
     void LisaControllerProxy::setSourceControlFlagAuxSend(SourceId_t src, ControlFlag_t flag){
         if (!isRunning()){
@@ -231,10 +985,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidControlFlag(flag));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceControlAuxSend, src);
-
-        sendToController(msg,1, STRING_T, kControlFlags[flag]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressControlAuxSend).str, kControlFlags[flag]);
     }
 
     void LisaControllerProxy::setAllSourcesControlFlags(ControlFlag_t flag) {
@@ -245,11 +996,13 @@ namespace LisaDeskbridge {
 
         const char * flagStr = kControlFlags[flag];
 
-        sendToController(kMsgSetAllSourcesControlPan,1, STRING_T, flagStr);
-        sendToController(kMsgSetAllSourcesControlWidth,1, STRING_T, flagStr);
-        sendToController(kMsgSetAllSourcesControlDistance,1, STRING_T, flagStr);
-        sendToController(kMsgSetAllSourcesControlElevation,1, STRING_T, flagStr);
-        sendToController(kMsgSetAllSourcesControlAuxSend,1, STRING_T, flagStr);
+        BundleScope bundle(*this);
+
+        send(MessageClassFlags, kMsgSetAllSourcesControlPan, flagStr);
+        send(MessageClassFlags, kMsgSetAllSourcesControlWidth, flagStr);
+        send(MessageClassFlags, kMsgSetAllSourcesControlDistance, flagStr);
+        send(MessageClassFlags, kMsgSetAllSourcesControlElevation, flagStr);
+        send(MessageClassFlags, kMsgSetAllSourcesControlAuxSend, flagStr);
     }
 
     void LisaControllerProxy::setAllSourcesControlBySnapshots() {
@@ -269,10 +1022,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourcePan, src);
+        flushPendingRelative();
 
-        sendToController(msg,1, FLOAT_T, value);
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValuePan), value)){
+            return;
+        }
+
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressPan).str, value);
     }
     void LisaControllerProxy::setSourceWidth(SourceId_t src, float value){
         if (!isRunning()){
@@ -281,10 +1037,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceWidth, src);
+        flushPendingRelative();
+
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValueWidth), value)){
+            return;
+        }
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressWidth).str, value);
     }
     void LisaControllerProxy::setSourceDistance(SourceId_t src, float value){
         if (!isRunning()){
@@ -293,10 +1052,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceDistance, src);
+        flushPendingRelative();
 
-        sendToController(msg,1, FLOAT_T, value);
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValueDistance), value)){
+            return;
+        }
+
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressDistance).str, value);
     }
     void LisaControllerProxy::setSourceElevation(SourceId_t src, float value){
         if (!isRunning()){
@@ -305,10 +1067,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceElevation, src);
+        flushPendingRelative();
 
-        sendToController(msg,1, FLOAT_T, value);
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValueElevation), value)){
+            return;
+        }
+
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressElevation).str, value);
     }
     void LisaControllerProxy::setSourcePanSpread(SourceId_t src, float value){
         if (!isRunning()){
@@ -317,10 +1082,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourcePanSpread, src);
+        flushPendingRelative();
+
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValuePanSpread), value)){
+            return;
+        }
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressPanSpread).str, value);
     }
     void LisaControllerProxy::setSourceAuxSend(SourceId_t src, float value){
         if (!isRunning()){
@@ -329,10 +1097,13 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceAuxSend, src);
+        flushPendingRelative();
+
+        if (!valueCache.shouldSend(LastValueCache::sourceIndex(src, SourceValueAuxSend), value)){
+            return;
+        }
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressAuxSend).str, value);
     }
 
     void LisaControllerProxy::setSourceAllParameters(SourceId_t src, float pan, float width, float depth, float elevation, float auxSend){
@@ -346,10 +1117,15 @@ namespace LisaDeskbridge {
         assert(isValidAbsoluteValue(elevation));
         assert(isValidAbsoluteValue(auxSend));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceAllParameters, src);
+        flushPendingRelative();
+
+        send(MessageClassSourceParam, oscAddresses.source(src, SourceAddressAllParameters).str, pan, width, depth, elevation, auxSend);
 
-        sendToController(msg,5, FLOAT_T, pan, FLOAT_T, width, FLOAT_T, depth, FLOAT_T, elevation, FLOAT_T, auxSend);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValuePan), pan);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueWidth), width);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueDistance), depth);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueElevation), elevation);
+        valueCache.update(LastValueCache::sourceIndex(src, SourceValueAuxSend), auxSend);
     }
 
 
@@ -360,10 +1136,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativePan, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativePan, value);
     }
     void LisaControllerProxy::setSourceRelativeWidth(SourceId_t src, float value){
         if (!isRunning()){
@@ -372,10 +1145,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativeWidth, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativeWidth, value);
     }
     void LisaControllerProxy::setSourceRelativeDistance(SourceId_t src, float value) {
         if (!isRunning()){
@@ -384,10 +1154,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativeDistance, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativeDistance, value);
     }
     void LisaControllerProxy::setSourceRelativeElevation(SourceId_t src, float value){
         if (!isRunning()){
@@ -396,10 +1163,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativeElevation, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativeElevation, value);
     }
     void LisaControllerProxy::setSourceRelativePanSpread(SourceId_t src, float value){
         if (!isRunning()){
@@ -408,10 +1172,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativePanSpread, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativePanSpread, value);
     }
     void LisaControllerProxy::setSourceRelativeAuxSend(SourceId_t src, float value){
         if (!isRunning()){
@@ -420,10 +1181,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceRelativeAuxSend, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetSource, src, RelativeAuxSend, value);
     }
 
     void LisaControllerProxy::setSourceFxIntensity(SourceId_t src, FxId_t fx, float value){
@@ -435,9 +1193,9 @@ namespace LisaDeskbridge {
         assert(isValidAbsoluteValue(value));
 
         char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceFxIntensity, src, fx);
+        std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceFxIntensity, src, fx);
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassSourceParam, msg, value);
     }
     void LisaControllerProxy::setSourceFxActive(SourceId_t src, FxId_t fx, bool on){
         if (!isRunning()){
@@ -447,9 +1205,9 @@ namespace LisaDeskbridge {
         assert(isValidFxId(fx));
 
         char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceFxOn, src, fx);
+        std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceFxOn, src, fx);
 
-        sendToController(msg,1, INT_T, on);
+        send(MessageClassSourceParam, msg, on);
     }
 
 
@@ -467,7 +1225,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidRelativeValue(value));
 
-        sendToController(kMsgSetSelectedSourcesRelativePan, 1, FLOAT_T, value);
+        sendRelative(RelativeTargetSelectedSources, 0, RelativePan, value);
     }
 
     void LisaControllerProxy::setSelectedSourcesRelativeWidth(float value) {
@@ -476,7 +1234,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidRelativeValue(value));
 
-        sendToController(kMsgSetSelectedSourcesRelativeWidth, 1, FLOAT_T, value);
+        sendRelative(RelativeTargetSelectedSources, 0, RelativeWidth, value);
     }
 
     void LisaControllerProxy::setSelectedSourcesRelativeDistance(float value) {
@@ -485,7 +1243,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidRelativeValue(value));
 
-        sendToController(kMsgSetSelectedSourcesRelativeDistance, 1, FLOAT_T, value);
+        sendRelative(RelativeTargetSelectedSources, 0, RelativeDistance, value);
     }
 
     void LisaControllerProxy::setSelectedSourcesRelativeElevation(float value) {
@@ -494,7 +1252,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidRelativeValue(value));
 
-        sendToController(kMsgSetSelectedSourcesRelativeElevation, 1, FLOAT_T, value);
+        sendRelative(RelativeTargetSelectedSources, 0, RelativeElevation, value);
     }
 
     void LisaControllerProxy::setSelectedSourcesRelativePanSpread(float value) {
@@ -503,7 +1261,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidRelativeValue(value));
 
-        sendToController(kMsgSetSelectedSourcesRelativePanSpread, 1, FLOAT_T, value);
+        sendRelative(RelativeTargetSelectedSources, 0, RelativePanSpread, value);
     }
 
 
@@ -515,10 +1273,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceSolo, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassOther, oscAddresses.source(src, SourceAddressSolo).str, on);
     }
 
     void LisaControllerProxy::setSelectedSourceSolo(bool on) {
@@ -535,10 +1290,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(0.0 <= value && value <= 200.0);
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceStaticDelayValue, src);
-
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassOther, oscAddresses.source(src, SourceAddressStaticDelayValue).str, value);
     }
 
     void LisaControllerProxy::setSelectedSourceStaticDelayValue(float value) {
@@ -551,10 +1303,7 @@ namespace LisaDeskbridge {
     void LisaControllerProxy::snapSourceToSpeaker(SourceId_t src){
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSnapSourceToSpeaker, src);
-
-        sendToController(msg,0);
+        send(MessageClassOther, oscAddresses.source(src, SourceAddressSnapToSpeaker).str);
     }
 
     void LisaControllerProxy::snapSelectedSourceToSpeaker() {
@@ -573,10 +1322,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptGain, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptGain).str, on);
     }
     void LisaControllerProxy::setSourceOptHpf(SourceId_t src, bool on){
         if (!isRunning()){
@@ -584,10 +1330,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptHpf, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptHpf).str, on);
     }
     void LisaControllerProxy::setSourceOptDelayEnabled(SourceId_t src, bool on){
         if (!isRunning()){
@@ -595,10 +1338,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptDelayEnabled, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptDelayEnabled).str, on);
     }
     void LisaControllerProxy::setSourceOptDelayMode(SourceId_t src, DelayMode_t mode){
         if (!isRunning()){
@@ -607,10 +1347,7 @@ namespace LisaDeskbridge {
         assert(isValidSourceId(src));
         assert(isValidDelayMode(mode));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptDelayMode, src);
-
-        sendToController(msg,1, STRING_T, kDelayModes[mode]);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptDelayMode).str, kDelayModes[mode]);
     }
     void LisaControllerProxy::setSourceOptReverbEarly(SourceId_t src, bool on){
         if (!isRunning()){
@@ -618,10 +1355,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptReverbEarly, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptReverbEarly).str, on);
     }
     void LisaControllerProxy::setSourceOptReverbCluster(SourceId_t src, bool on){
         if (!isRunning()){
@@ -629,10 +1363,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptReverbCluster, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptReverbCluster).str, on);
     }
     void LisaControllerProxy::setSourceOptReverbLate(SourceId_t src, bool on){
         if (!isRunning()){
@@ -640,10 +1371,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptReverbLate, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptReverbLate).str, on);
     }
     void LisaControllerProxy::setSourceOptDirectSound(SourceId_t src, bool on){
         if (!isRunning()){
@@ -651,10 +1379,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSourceOptDirectSound, src);
-
-        sendToController(msg,1, INT_T, (int)on);
+        send(MessageClassFlags, oscAddresses.source(src, SourceAddressOptDirectSound).str, on);
     }
 
 
@@ -667,10 +1392,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupPan, grp);
+        flushPendingRelative();
+
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValuePan);
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressPan).str, value);
     }
     void LisaControllerProxy::setGroupWidth(GroupId_t grp, float value){
         if (!isRunning()){
@@ -679,10 +1406,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupWidth, grp);
+        flushPendingRelative();
+
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValueWidth);
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressWidth).str, value);
     }
     void LisaControllerProxy::setGroupDistance(GroupId_t grp, float value){
         if (!isRunning()){
@@ -691,10 +1420,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupDistance, grp);
+        flushPendingRelative();
+
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValueDistance);
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressDistance).str, value);
     }
     void LisaControllerProxy::setGroupElevation(GroupId_t grp, float value){
         if (!isRunning()){
@@ -703,10 +1434,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupElevation, grp);
+        flushPendingRelative();
+
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValueElevation);
 
-        sendToController(msg,1, FLOAT_T, value);
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressElevation).str, value);
     }
     void LisaControllerProxy::setGroupPanSpread(GroupId_t grp, float value){
         if (!isRunning()){
@@ -715,10 +1448,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupPanSpread, grp);
+        flushPendingRelative();
 
-        sendToController(msg,1, FLOAT_T, value);
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValuePanSpread);
+
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressPanSpread).str, value);
     }
     void LisaControllerProxy::setGroupAuxSend(GroupId_t grp, float value){
         if (!isRunning()){
@@ -727,10 +1462,12 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidAbsoluteValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupAuxSend, grp);
+        flushPendingRelative();
 
-        sendToController(msg,1, FLOAT_T, value);
+        // group members are not known
+        valueCache.invalidateSourceParam(SourceValueAuxSend);
+
+        send(MessageClassGroupParam, oscAddresses.group(grp, GroupAddressAuxSend).str, value);
     }
 
     void LisaControllerProxy::setGroupRelativePan(GroupId_t grp, float value){
@@ -740,10 +1477,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativePan, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativePan, value);
     }
     void LisaControllerProxy::setGroupRelativeWidth(GroupId_t grp, float value){
         if (!isRunning()){
@@ -752,10 +1486,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativeWidth, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativeWidth, value);
     }
     void LisaControllerProxy::setGroupRelativeDistance(GroupId_t grp, float value){
         if (!isRunning()){
@@ -764,10 +1495,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativeDistance, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativeDistance, value);
     }
     void LisaControllerProxy::setGroupRelativeElevation(GroupId_t grp, float value){
         if (!isRunning()){
@@ -776,10 +1504,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativeElevation, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativeElevation, value);
     }
     void LisaControllerProxy::setGroupRelativePanSpread(GroupId_t grp, float value){
         if (!isRunning()){
@@ -788,10 +1513,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativePanSpread, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativePanSpread, value);
     }
     void LisaControllerProxy::setGroupRelativeAuxSend(GroupId_t grp, float value){
         if (!isRunning()){
@@ -800,10 +1522,7 @@ namespace LisaDeskbridge {
         assert(isValidGroupId(grp));
         assert(isValidRelativeValue(value));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetGroupRelativeAuxSend, grp);
-
-        sendToController(msg,1, FLOAT_T, value);
+        sendRelative(RelativeTargetGroup, grp, RelativeAuxSend, value);
     }
 
     // Snapshots
@@ -814,45 +1533,61 @@ namespace LisaDeskbridge {
         }
         assert(isValidSnapshotId(snapshot));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgFireSnapshot, snapshot);
+        flushRelative();
+        valueCache.invalidateSources();
 
-        sendToController(msg,0);
+        if (oscAddresses.hasSnapshot(snapshot)){
+            send(MessageClassSnapshot, oscAddresses.snapshot(snapshot).str);
+        } else {
+            OscAddress address;
+            OscAddressTable::expand(address, kMsgFireSnapshot, snapshot);
+
+            send(MessageClassSnapshot, address.str);
+        }
     }
     void LisaControllerProxy::firePreviousSnapshot() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgFirePreviousSnapshot, 0);
+        flushRelative();
+        valueCache.invalidateSources();
+
+        send(MessageClassSnapshot, kMsgFirePreviousSnapshot);
     }
     void LisaControllerProxy::fireNextSnapshot() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgFireNextSnapshot, 0);
+        flushRelative();
+        valueCache.invalidateSources();
+
+        send(MessageClassSnapshot, kMsgFireNextSnapshot);
     }
     void LisaControllerProxy::refireCurrentSnapshot() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgRefireCurrentSnapshot, 0);
+        flushRelative();
+        valueCache.invalidateSources();
+
+        send(MessageClassSnapshot, kMsgRefireCurrentSnapshot);
     }
     void LisaControllerProxy::saveCurrentSnapshot() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgSaveCurrentSnapshot, 0);
+        send(MessageClassSnapshot, kMsgSaveCurrentSnapshot);
     }
     void LisaControllerProxy::saveAsNewSnapshot() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgSaveAsNewSnapshot, 0);
+        send(MessageClassSnapshot, kMsgSaveAsNewSnapshot);
     }
 
     // Reverbs
@@ -863,10 +1598,14 @@ namespace LisaDeskbridge {
         }
         assert(isValidReverbId(reverb));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgLoadReverbPreset, reverb);
+        if (oscAddresses.hasReverb(reverb)){
+            send(MessageClassOther, oscAddresses.reverb(reverb).str);
+        } else {
+            OscAddress address;
+            OscAddressTable::expand(address, kMsgLoadReverbPreset, reverb);
 
-        sendToController(msg,0);
+            send(MessageClassOther, address.str);
+        }
     }
 
     // FX
@@ -877,10 +1616,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidFxId(fx));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgStartFx, fx);
-
-        sendToController(msg,0);
+        send(MessageClassOther, oscAddresses.fx(fx, FxAddressStart).str);
     }
     void LisaControllerProxy::restartFx(FxId_t fx){
         if (!isRunning()){
@@ -888,10 +1624,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidFxId(fx));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgRestartFx, fx);
-
-        sendToController(msg,0);
+        send(MessageClassOther, oscAddresses.fx(fx, FxAddressRestart).str);
     }
     void LisaControllerProxy::stopFx(FxId_t fx){
         if (!isRunning()){
@@ -899,10 +1632,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidFxId(fx));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgStopFx, fx);
-
-        sendToController(msg,0);
+        send(MessageClassOther, oscAddresses.fx(fx, FxAddressStop).str);
     }
 
     // BPM
@@ -912,7 +1642,7 @@ namespace LisaDeskbridge {
             return;
         }
 
-        sendToController(kMsgLockBpmToMidiClock, 1, INT_T, (int)on);
+        send(MessageClassOther, kMsgLockBpmToMidiClock, on);
     }
     void LisaControllerProxy::setBPM(float bpm){
         if (!isRunning()){
@@ -920,14 +1650,14 @@ namespace LisaDeskbridge {
         }
         assert(isValidBpm(bpm));
 
-        sendToController(kMsgSetBpm, 1, FLOAT_T, bpm);
+        send(MessageClassOther, kMsgSetBpm, bpm);
     }
     void LisaControllerProxy::tapTempo() {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgBpmTap, 0);
+        send(MessageClassOther, kMsgBpmTap);
     }
 
     // Master Fader
@@ -938,7 +1668,11 @@ namespace LisaDeskbridge {
         }
         assert(isValidGain(gain));
 
-        sendToController(kMsgSetMasterGain, 1, FLOAT_T, gain);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueMasterGain), gain)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetMasterGain, gain);
     }
 
     void LisaControllerProxy::setMasterFaderPos(float pos) {
@@ -947,7 +1681,11 @@ namespace LisaDeskbridge {
         }
         assert(isValidFaderPos(pos));
 
-        sendToController(kMsgSetMasterFaderPos, 1, FLOAT_T, pos);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueMasterPos), pos)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetMasterFaderPos, pos);
     }
 
     void LisaControllerProxy::setMasterMute(bool on) {
@@ -955,7 +1693,7 @@ namespace LisaDeskbridge {
             return;
         }
 
-        sendToController(kMsgSetMasterMute, 1, INT_T, (int)on);
+        send(MessageClassFader, kMsgSetMasterMute, on);
     }
 
 
@@ -967,7 +1705,11 @@ namespace LisaDeskbridge {
         }
         assert(isValidGain(gain));
 
-        sendToController(kMsgSetReverbGain, 1, FLOAT_T, gain);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueReverbGain), gain)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetReverbGain, gain);
     }
 
     void LisaControllerProxy::setReverbFaderPos(float pos) {
@@ -976,7 +1718,11 @@ namespace LisaDeskbridge {
         }
         assert(isValidFaderPos(pos));
 
-        sendToController(kMsgSetReverbFaderPos, 1, FLOAT_T, pos);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueReverbPos), pos)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetReverbFaderPos, pos);
     }
 
     void LisaControllerProxy::setReverbMute(bool on) {
@@ -984,7 +1730,7 @@ namespace LisaDeskbridge {
             return;
         }
 
-        sendToController(kMsgSetReverbMute, 1, INT_T, (int)on);
+        send(MessageClassFader, kMsgSetReverbMute, on);
     }
 
 
@@ -996,7 +1742,11 @@ namespace LisaDeskbridge {
         }
         assert(isValidGain(gain));
 
-        sendToController(kMsgSetMonitorGain, 1, FLOAT_T, gain);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueMonitorGain), gain)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetMonitorGain, gain);
     }
     void LisaControllerProxy::setMonitorFaderPos(float pos)  {
         if (!isRunning()){
@@ -1004,14 +1754,18 @@ namespace LisaDeskbridge {
         }
         assert(isValidFaderPos(pos));
 
-        sendToController(kMsgSetMonitorFaderPos, 1, FLOAT_T, pos);
+        if (!valueCache.shouldSend(LastValueCache::faderIndex(FaderValueMonitorPos), pos)){
+            return;
+        }
+
+        send(MessageClassFader, kMsgSetMonitorFaderPos, pos);
     }
     void LisaControllerProxy::setMonitorMute(bool on) {
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgSetMonitorMute, 1, INT_T, (int)on);
+        send(MessageClassFader, kMsgSetMonitorMute, on);
     }
 
     // User Fader
@@ -1023,10 +1777,11 @@ namespace LisaDeskbridge {
         assert(1 <= fader && fader <= 2);
         assert(isValidGain(gain));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetUserFaderNGain, fader);
+        if (!valueCache.shouldSend(LastValueCache::userFaderIndex(fader, false), gain)){
+            return;
+        }
 
-        sendToController(msg, 1, FLOAT_T, gain);
+        send(MessageClassFader, oscAddresses.userFader(fader, UserFaderAddressGain).str, gain);
     }
     void LisaControllerProxy::setUserFaderNPos(int fader, float pos) {
         if (!isRunning()){
@@ -1035,10 +1790,11 @@ namespace LisaDeskbridge {
         assert(1 <= fader && fader <= 2);
         assert(isValidFaderPos(pos));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetUserFaderNPos, fader);
+        if (!valueCache.shouldSend(LastValueCache::userFaderIndex(fader, true), pos)){
+            return;
+        }
 
-        sendToController(msg, 1, FLOAT_T, pos);
+        send(MessageClassFader, oscAddresses.userFader(fader, UserFaderAddressPos).str, pos);
     }
     void LisaControllerProxy::setUserFaderNMute(int fader, bool on) {
         if (!isRunning()){
@@ -1046,10 +1802,7 @@ namespace LisaDeskbridge {
         }
         assert(1 <= fader && fader <= 2);
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetUserFaderNMute, fader);
-
-        sendToController(msg, 1, INT_T, (int)on);
+        send(MessageClassFader, oscAddresses.userFader(fader, UserFaderAddressMute).str, on);
     }
 
 
@@ -1061,10 +1814,9 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSelectionToSource, src);
+        flushRelative();
 
-        sendToController(msg, 0);
+        send(MessageClassSelection, oscAddresses.source(src, SourceAddressSetSelection).str);
 
         lastSelectedSource = src;
     }
@@ -1075,10 +1827,9 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgChangeSelectionOfSource, src);
+        flushRelative();
 
-        sendToController(msg, 1, INT_T, 1);
+        send(MessageClassSelection, oscAddresses.source(src, SourceAddressChangeSelection).str, 1);
 
         lastSelectedSource = 0;
     }
@@ -1089,10 +1840,9 @@ namespace LisaDeskbridge {
         }
         assert(isValidSourceId(src));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgChangeSelectionOfSource, src);
+        flushRelative();
 
-        sendToController(msg, 1, INT_T, 0);
+        send(MessageClassSelection, oscAddresses.source(src, SourceAddressChangeSelection).str, 0);
 
         lastSelectedSource = 0;
     }
@@ -1103,10 +1853,9 @@ namespace LisaDeskbridge {
         }
         assert(isValidGroupId(grp));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetSelectionToGroup, grp);
+        flushRelative();
 
-        sendToController(msg, 0);
+        send(MessageClassSelection, oscAddresses.group(grp, GroupAddressSetSelection).str);
 
         lastSelectedSource = 0;
     }
@@ -1116,7 +1865,9 @@ namespace LisaDeskbridge {
             return;
         }
 
-        sendToController(kMsgClearSelection, 0);
+        flushRelative();
+
+        send(MessageClassSelection, kMsgClearSelection);
 
         lastSelectedSource = 0;
     }
@@ -1131,14 +1882,14 @@ namespace LisaDeskbridge {
         assert(isValidPitch(pitch));
         assert(isValidRoll(roll));
 
-        sendToController(kMsgSetHeadtrackerOrientation, 3, FLOAT_T, yaw, FLOAT_T, pitch, FLOAT_T, roll);
+        send(MessageClassOther, kMsgSetHeadtrackerOrientation, yaw, pitch, roll);
     }
     void LisaControllerProxy::resetHeadtracker(){
         if (!isRunning()){
             return;
         }
 
-        sendToController(kMsgResetHeadtracker, 0);
+        send(MessageClassOther, kMsgResetHeadtracker);
     }
     void LisaControllerProxy::setHeadtrackerType(HeadtrackerType_t type){
         if (!isRunning()){
@@ -1146,7 +1897,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidHeadtrackerType(type));
 
-        sendToController(kMsgSetHeadtrackerType, 1, STRING_T, kHeadtrackerTypes[type]);
+        send(MessageClassOther, kMsgSetHeadtrackerType, kHeadtrackerTypes[type]);
     }
 
 
@@ -1158,10 +1909,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgRegisterDevice, device);
-
-        sendToController(msg, 2, STRING_T, ipAddress, INT_T, port);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressRegister).str, ipAddress, (int)port);
     }
     void LisaControllerProxy::unregisterDevice(DeviceId_t device){
         if (!isRunning()){
@@ -1169,10 +1917,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgDeleteDevice, device);
-
-        sendToController(msg, 0);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressDelete).str);
     }
     void LisaControllerProxy::setDeviceName(DeviceId_t device, const char name[]){
         if (!isRunning()){
@@ -1180,10 +1925,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetDeviceName, device);
-
-        sendToController(msg, 1, STRING_T, name);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressName).str, name);
     }
     void LisaControllerProxy::enableSendingToDevice(DeviceId_t device, bool enable){
         if (!isRunning()){
@@ -1191,10 +1933,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgEnableSendingToDevice, device);
-
-        sendToController(msg, 1, INT_T, (int)enable);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressEnableSending).str, enable);
     }
     void LisaControllerProxy::enableReceivingFromDevice(DeviceId_t device, bool enable){
         if (!isRunning()){
@@ -1202,10 +1941,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgEnableReceivingFromDevice, device);
-
-        sendToController(msg, 1, INT_T, (int)enable);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressEnableReceiving).str, enable);
     }
     void LisaControllerProxy::setDeviceCoordFormat(DeviceId_t device, CoordFormat_t format){
         if (!isRunning()){
@@ -1214,10 +1950,7 @@ namespace LisaDeskbridge {
         assert(isValidDeviceId(device));
         assert(isValidCoordFormat(format));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetDeviceCoordFormat, device);
-
-        sendToController(msg, 1, STRING_T, kCoordFormats[format]);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressCoordFormat).str, kCoordFormats[format]);
     }
     void LisaControllerProxy::setMasterGainControl(DeviceId_t device, bool on){
         if (!isRunning()){
@@ -1225,10 +1958,7 @@ namespace LisaDeskbridge {
         }
         assert(isValidDeviceId(device));
 
-        char msg[64];
-        int l = std::snprintf(msg, sizeof(msg), (char*)kMsgSetMasterGainControl, device);
-
-        sendToController(msg, 1, INT_T, (int)on);
+        send(MessageClassDevice, oscAddresses.device(device, DeviceAddressMasterGainControl).str, on);
     }
 
     // ping
@@ -1238,7 +1968,13 @@ namespace LisaDeskbridge {
             return;
         }
 
-        sendToController(kMsgPing, 2, STRING_T, ipAddress, INT_T, port);
+        // should the previous one have been lost, measure from this one
+        uint64_t now = latencyNow();
+        for(unsigned int i = 0; i < controllerCount; i++){
+            controllers[i].pingSentAt.store(now, std::memory_order_release);
+        }
+
+        send(MessageClassDevice, kMsgPing, ipAddress, (int)port);
     }
 
 } // LisaDeskbridge
\ No newline at end of file
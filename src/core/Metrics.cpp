@@ -0,0 +1,112 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Metrics.h"
+
+namespace LisaDeskbridge {
+
+    Metrics metrics;
+
+    static const char * const kMidiTypeNames[MidiTypeCount] = {
+            "note_off",
+            "note_on",
+            "poly_pressure",
+            "control_change",
+            "program_change",
+            "aftertouch",
+            "pitch_bend",
+            "system"
+    };
+
+    static const char * const kMixerEventNames[MixerEventCount] = {
+            "channel_select",
+            "midi_soft_rotary",
+            "midi_soft_key",
+            "midi_fader_level"
+    };
+
+    void writePrometheusHeader(FILE * file, const char * name, const char * type, const char * help){
+        fprintf(file, "# HELP %s %s\n", name, help);
+        fprintf(file, "# TYPE %s %s\n", name, type);
+    }
+
+    void writePrometheusValue(FILE * file, const char * name, uint64_t value, const char * label, const char * labelValue){
+        if (label == nullptr){
+            fprintf(file, "%s %llu\n", name, (unsigned long long)value);
+        } else {
+            fprintf(file, "%s{%s=\"%s\"} %llu\n", name, label, labelValue, (unsigned long long)value);
+        }
+    }
+
+    void Metrics::writePrometheus(FILE * file) const {
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_tx_messages_total", "counter", "OSC messages sent to L-ISA Controller");
+        for(int i = 0; i < MessageClassCount; i++){
+            writePrometheusValue(file, "lisa_deskbridge_osc_tx_messages_total", oscTxMessages[i].get(), "class", messageClassName((MessageClass_t)i));
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_messages_total", "counter", "OSC messages received from L-ISA Controller");
+        for(int i = 0; i < MessageClassCount; i++){
+            writePrometheusValue(file, "lisa_deskbridge_osc_rx_messages_total", oscRxMessages[i].get(), "class", messageClassName((MessageClass_t)i));
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_parse_errors_total", "counter", "Received OSC messages that could not be parsed");
+        writePrometheusValue(file, "lisa_deskbridge_osc_rx_parse_errors_total", oscRxParseErrors.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_ignored_total", "counter", "Received OSC messages ignored because they came from a standby L-ISA Controller");
+        writePrometheusValue(file, "lisa_deskbridge_osc_rx_ignored_total", oscRxIgnored.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_datagrams_total", "counter", "Datagrams received from L-ISA Controller");
+        writePrometheusValue(file, "lisa_deskbridge_osc_rx_datagrams_total", oscRxDatagrams.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_batches_total", "counter", "Batches (wakeups) the received datagrams came in");
+        writePrometheusValue(file, "lisa_deskbridge_osc_rx_batches_total", oscRxBatches.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_osc_rx_coalesced_total", "counter", "Received values superseded by a later one in the same batch (not handed on)");
+        writePrometheusValue(file, "lisa_deskbridge_osc_rx_coalesced_total", oscRxCoalesced.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_midi_rx_messages_total", "counter", "MIDI messages received (and handled)");
+        for(int i = 0; i < MidiTypeCount; i++){
+            writePrometheusValue(file, "lisa_deskbridge_midi_rx_messages_total", midiRxMessages[i].get(), "type", kMidiTypeNames[i]);
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_midi_rx_ignored_total", "counter", "MIDI messages dropped as not handled by the bridge");
+        writePrometheusValue(file, "lisa_deskbridge_midi_rx_ignored_total", midiRxIgnored.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_midi_tx_messages_total", "counter", "MIDI messages sent");
+        writePrometheusValue(file, "lisa_deskbridge_midi_tx_messages_total", midiTxMessages.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_midi_tx_superseded_total", "counter", "MIDI control changes replaced by a later value before being sent");
+        writePrometheusValue(file, "lisa_deskbridge_midi_tx_superseded_total", midiTxSuperseded.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_midi_tx_dropped_total", "counter", "MIDI messages dropped as the output queue was full");
+        writePrometheusValue(file, "lisa_deskbridge_midi_tx_dropped_total", midiTxDropped.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_mixer_events_total", "counter", "SQ mixer events received");
+        for(int i = 0; i < MixerEventCount; i++){
+            writePrometheusValue(file, "lisa_deskbridge_mixer_events_total", mixerEvents[i].get(), "type", kMixerEventNames[i]);
+        }
+
+        writePrometheusHeader(file, "lisa_deskbridge_relative_changes_total", "counter", "Relative parameter changes requested");
+        writePrometheusValue(file, "lisa_deskbridge_relative_changes_total", relativeChanges.get());
+
+        writePrometheusHeader(file, "lisa_deskbridge_relative_messages_total", "counter", "Relative parameter change messages sent (after coalescing)");
+        writePrometheusValue(file, "lisa_deskbridge_relative_messages_total", relativeMessages.get());
+    }
+
+}
@@ -34,8 +34,10 @@ namespace LisaDeskbridge {
         mInPortName = inPortName;
         mOutPortName = outPortName;
 
-        log(LogLevelInfo, "Scanning for IN port = '%s'", mInPortName);
-        log(LogLevelInfo, "Scanning for OUT port = '%s'", mOutPortName);
+        startPairTimer();
+
+        LISA_LOG(LogLevelInfo, "Scanning for IN port = '%s'", mInPortName);
+        LISA_LOG(LogLevelInfo, "Scanning for OUT port = '%s'", mOutPortName);
 
         observer = new libremidi::observer ({
                 .track_hardware = true,
@@ -44,13 +46,13 @@ namespace LisaDeskbridge {
 //                     std::cout << "Added IN port = " << port.port_name << std::endl;
 
                     if (mInPortName.length() > 0 && port.port_name == mInPortName){
-                        log(LogLevelInfo, "Found MIDI IN port '%s'. Opening..", mInPortName );
+                        LISA_LOG(LogLevelInfo, "Found MIDI IN port '%s'. Opening..", mInPortName );
                         if (midiIn.is_port_open()){
                             midiIn.close_port();
                         }
                         stdx::error e = midiIn.open_port(port, mInPortName);
                         if (e.is_set()){
-                            log(LogLevelError,"opening midi IN port: %s", e.message().data() );
+                            LISA_LOG(LogLevelError,"opening midi IN port: %s", e.message().data() );
                         }
                     }
                 },
@@ -60,20 +62,20 @@ namespace LisaDeskbridge {
 
                     if (mInPortName.length() > 0 && port.port_name == mInPortName){
                         midiIn.close_port();
-                        log(LogLevelInfo, "Lost MIDI IN port '%s'. Waiting for reconnection..", mInPortName );
+                        LISA_LOG(LogLevelInfo, "Lost MIDI IN port '%s'. Waiting for reconnection..", mInPortName );
                     }
                 },
                 .output_added = [&](const libremidi::output_port &port){
 //                    std::cerr << "Added OUT port = " << port.port_name << std::endl;
 
                     if (mOutPortName.length() > 0 && port.port_name == mOutPortName){
-                        log(LogLevelInfo, "Found MIDI OUT port '%s'. Opening..", mOutPortName );
+                        LISA_LOG(LogLevelInfo, "Found MIDI OUT port '%s'. Opening..", mOutPortName );
                         if (midiOut.is_port_open()){
                             midiOut.close_port();
                         }
                         stdx::error e = midiOut.open_port(port, mOutPortName);
                         if (e.is_set()){
-                            log(LogLevelError,"opening midi OUT port: %s", e.message().data() );
+                            LISA_LOG(LogLevelError,"opening midi OUT port: %s", e.message().data() );
                         }
                     }
                 },
@@ -83,7 +85,7 @@ namespace LisaDeskbridge {
 
                     if (mOutPortName.length() > 0 && port.port_name == mOutPortName){
                         midiOut.close_port();
-                        log(LogLevelInfo, "Lost MIDI OUT port '%s'. Waiting for reconnection..", mOutPortName );
+                        LISA_LOG(LogLevelInfo, "Lost MIDI OUT port '%s'. Waiting for reconnection..", mOutPortName );
                     }
                 }
         });
@@ -95,6 +97,8 @@ namespace LisaDeskbridge {
 
         midiIn.close_port();
         midiOut.close_port();
+
+        stopPairTimer();
     }
 
 }
\ No newline at end of file
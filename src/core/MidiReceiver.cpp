@@ -17,60 +17,503 @@
 */
 
 #include "MidiReceiver.h"
+#include "Capture.h"
+#include "Latency.h"
+#include "LisaControllerProxy.h"
+#include "Metrics.h"
+#include "log.h"
 
+#include <cassert>
 #include <iostream>
 
 namespace LisaDeskbridge {
 
-    void MidiReceiver::Delegate::receivedMessage(const libremidi::message& message){
+    // channel voice message handlers (channels are reported 1-based)
 
-//        std::cout << "MESSAGE type(" << (int)message.get_message_type() << ") channel(" << message.get_channel() << ")" << std::endl;
+    static void dispatchNoteOff(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 3){
+            delegate.receivedNoteOff((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        }
+    }
+
+    static void dispatchNoteOn(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size < 3){
+            return;
+        }
+        if (bytes[2] == 0){ // a note on message with velocity 0 is considered a note off
+            delegate.receivedNoteOff((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        } else {
+            delegate.receivedNoteOn((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        }
+    }
+
+    static void dispatchPolyPressure(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 3){
+            delegate.receivedPolyPressure((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        }
+    }
+
+    static void dispatchControlChange(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 3){
+            delegate.receivedControlChange((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        }
+    }
+
+    static void dispatchProgramChange(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 2){
+            delegate.receivedProgramChange((bytes[0] & 0x0F) + 1, bytes[1]);
+        }
+    }
+
+    static void dispatchAftertouch(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 2){
+            delegate.receivedAftertouch((bytes[0] & 0x0F) + 1, bytes[1]);
+        }
+    }
+
+    static void dispatchPitchBend(MidiReceiver::Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 3){
+            // least significant bytes first...
+            int i14 = (((int)bytes[2]) << 7) + ((int)bytes[1]);
+            delegate.receivedPitchBend((bytes[0] & 0x0F) + 1, i14);
+        }
+    }
+
+    // by MidiType_t
+    static const MidiReceiver::Delegate::Handler kDispatchers[MidiTypeSystem] = {
+            dispatchNoteOff,
+            dispatchNoteOn,
+            dispatchPolyPressure,
+            dispatchControlChange,
+            dispatchProgramChange,
+            dispatchAftertouch,
+            dispatchPitchBend
+    };
+
+    MidiReceiver::Delegate::Delegate(){
+        ignoreAll();
+        for(int type = 0; type < MidiTypeSystem; type++){
+            handle((MidiType_t)type);
+        }
+    }
+
+    void MidiReceiver::Delegate::handle(MidiType_t type, int channel){
+        assert(type < MidiTypeSystem);
+        assert(channel == kAllChannels || (1 <= channel && channel <= 16));
+
+        unsigned int status = 0x80 | (type << 4);
+
+        Handler handler = kDispatchers[type];
+        if (type == MidiTypeControlChange && highResolution != nullptr){
+            handler = dispatchHighResolution;
+        }
+
+        if (channel == kAllChannels){
+            for(unsigned int i = 0; i < 16; i++){
+                handlers[status | i] = handler;
+            }
+        } else {
+            handlers[status | (channel - 1)] = handler;
+        }
+    }
+
+    void MidiReceiver::Delegate::ignore(MidiType_t type, int channel){
+        assert(channel == kAllChannels || (1 <= channel && channel <= 16));
+
+        unsigned int status = 0x80 | (type << 4);
+
+        if (channel == kAllChannels || type == MidiTypeSystem){
+            for(unsigned int i = 0; i < 16; i++){
+                handlers[status | i] = nullptr;
+            }
+        } else {
+            handlers[status | (channel - 1)] = nullptr;
+        }
+    }
+
+    void MidiReceiver::Delegate::ignoreAll(){
+        for(unsigned int i = 0; i < 256; i++){
+            handlers[i] = nullptr;
+        }
+    }
+
+    void MidiReceiver::Delegate::assembleControlChange14(int cc, int channel, bool enabled){
+        assert(0 <= cc && cc < 32);
+        assert(channel == kAllChannels || (1 <= channel && channel <= 16));
+
+        if (highResolution == nullptr){
+            if (!enabled){
+                return;
+            }
 
-        int i14 = 0;
-        switch(message.get_message_type()){
-            case libremidi::message_type::NOTE_ON:
-                if (message.bytes[2] == 0){ // a note on message with velocity 0 is considered a note off
-                    receivedNoteOff(message.get_channel(), message.bytes[1], message.bytes[2]);
-                } else {
-                    receivedNoteOn(message.get_channel(), message.bytes[1], message.bytes[2]);
+            highResolution = std::make_unique<HighResolutionState>();
+
+            // control changes handled so far go through assembly
+            for(unsigned int i = 0; i < 16; i++){
+                if (handlers[0xB0 | i] != nullptr){
+                    handlers[0xB0 | i] = dispatchHighResolution;
                 }
-                break;
-            case libremidi::message_type::NOTE_OFF:
-                receivedNoteOff(message.get_channel(), message.bytes[1], message.bytes[2]);
-                break;
-            case libremidi::message_type::CONTROL_CHANGE:
-                receivedControlChange(message.get_channel(), message.bytes[1], message.bytes[2]);
-                break;
-            case libremidi::message_type::POLY_PRESSURE:
-                receivedPolyPressure(message.get_channel(), message.bytes[1], message.bytes[2]);
-                break;
-            case libremidi::message_type::PROGRAM_CHANGE:
-                receivedProgramChange(message.get_channel(), message.bytes[1]);
-                break;
-            case libremidi::message_type::AFTERTOUCH:
-                receivedAftertouch(message.get_channel(), message.bytes[1]);
-                break;
-            case libremidi::message_type::PITCH_BEND:
-                // least significant bytes first...
-                i14 = (((int)message.bytes[2]) << 7) + ((int)message.bytes[1]);
-                receivedPitchBend(message.get_channel(), i14);
-                break;
-            default:
-                // unprocessed message
-                break;
+            }
+        }
+
+        for(int i = 0; i < 16; i++){
+            if (channel != kAllChannels && channel != i + 1){
+                continue;
+            }
+            if (enabled){
+                highResolution->channels[i].pairs |= ((uint32_t)1) << cc;
+            } else {
+                highResolution->channels[i].pairs &= ~(((uint32_t)1) << cc);
+            }
+        }
+    }
+
+    void MidiReceiver::Delegate::assembleParameterNumbers(bool enabled){
+        if (highResolution == nullptr && !enabled){
+            return;
+        }
+
+        // data entry is a 14-bit pair (CC 6/38) delivered as parameter change (if one is selected)
+        assembleControlChange14(6, kAllChannels, enabled);
+
+        highResolution->parameterNumbers = enabled;
+    }
+
+    void MidiReceiver::Delegate::dispatchHighResolution(Delegate & delegate, const unsigned char * bytes, std::size_t size){
+        if (size >= 3){
+            delegate.receivedHighResolution((bytes[0] & 0x0F) + 1, bytes[1], bytes[2]);
+        }
+    }
+
+    void MidiReceiver::Delegate::receivedHighResolution(int channel, int cc, int value){
+        HighResolutionState & state = *highResolution;
+        HighResolutionState::Channel & ch = state.channels[channel - 1];
+
+        // a given up MSB and the event at hand
+        Delivery deliveries[2];
+        int count = 0;
+        bool plain = false;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            // give up on a pending MSB, unless this is its LSB
+            if (ch.pending != -1 && (cc != ch.pending + 32 || kPairTimeout < messageTime - ch.pendingSince)){
+                int msbCC = ch.pending;
+                setPending(ch, -1, 0);
+                if (resolveHighResolution(channel, msbCC, ((int)ch.msb[msbCC]) << 7, deliveries[count])){
+                    count++;
+                }
+            }
+
+            if (cc < 32 && (ch.pairs & (((uint32_t)1) << cc))){
+                ch.msb[cc] = value;
+
+                if (ch.lsbSeen & (((uint32_t)1) << cc)){
+                    setPending(ch, cc, messageTime);
+                } else if (resolveHighResolution(channel, cc, value << 7, deliveries[count])){
+                    count++;
+                }
+            }
+            else if (32 <= cc && cc < 64 && (ch.pairs & (((uint32_t)1) << (cc - 32)))){
+                int msbCC = cc - 32;
+
+                ch.lsbSeen |= ((uint32_t)1) << msbCC;
+
+                // completes the pending MSB or (if sent on its own) refines the last one
+                setPending(ch, -1, 0);
+                if (resolveHighResolution(channel, msbCC, (((int)ch.msb[msbCC]) << 7) | value, deliveries[count])){
+                    count++;
+                }
+            }
+            else if (state.parameterNumbers && 98 <= cc && cc <= 101){
+                if (cc == 99 || cc == 101){ // NRPN resp. RPN MSB
+                    ch.parameterMsb = value;
+                } else { // NRPN resp. RPN LSB
+                    ch.parameterLsb = value;
+                }
+                ch.registered = cc == 101 || cc == 100;
+            }
+            else {
+                plain = true;
+            }
+        }
+
+        for(int i = 0; i < count; i++){
+            deliverHighResolution(deliveries[i]);
+        }
+
+        if (plain){
+            receivedControlChange(channel, cc, value);
+        }
+    }
+
+    bool MidiReceiver::Delegate::resolveHighResolution(int channel, int cc, int value, Delivery & delivery){
+        HighResolutionState::Channel & ch = highResolution->channels[channel - 1];
+
+        delivery.channel = channel;
+        delivery.value = value;
+
+        if (cc == 6 && highResolution->parameterNumbers){
+            // 127/127 = RPN null, ie. data entry is not meant for any parameter
+            if (ch.parameterMsb == 127 && ch.parameterLsb == 127){
+                return false;
+            }
+            delivery.number = (((int)ch.parameterMsb) << 7) | ch.parameterLsb;
+            delivery.parameter = true;
+            delivery.registered = ch.registered;
+            return true;
+        }
+
+        delivery.number = cc;
+        delivery.parameter = false;
+        delivery.registered = false;
+        return true;
+    }
+
+    void MidiReceiver::Delegate::deliverHighResolution(const Delivery & delivery){
+        if (delivery.parameter){
+            receivedParameterChange(delivery.channel, delivery.number, delivery.value, delivery.registered);
+        } else {
+            receivedControlChange14(delivery.channel, delivery.number, delivery.value);
+        }
+    }
+
+    void MidiReceiver::Delegate::setPending(HighResolutionState::Channel & ch, int cc, uint64_t since){
+        if ((ch.pending == -1) != (cc == -1)){
+            if (cc == -1){
+                highResolution->pendingCount.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                highResolution->pendingCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (cc != -1){
+            highResolution->pendingSet = true;
+
+            // only wake the timer thread if it went to sleep for good
+            if (highResolution->timerIdle){
+                highResolution->timerIdle = false;
+                highResolution->timerWake.notify_one();
+            }
+        }
+        ch.pending = cc;
+        ch.pendingSince = since;
+    }
+
+    void MidiReceiver::Delegate::expireHighResolution(uint64_t now){
+        HighResolutionState & state = *highResolution;
+
+        if (state.pendingCount.load(std::memory_order_relaxed) == 0){
+            return;
+        }
+
+        Delivery deliveries[16];
+        int count = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            for(int i = 0; i < 16; i++){
+                HighResolutionState::Channel & ch = state.channels[i];
+
+                if (ch.pending != -1 && ch.pendingSince + kPairTimeout <= now){
+                    int msbCC = ch.pending;
+                    setPending(ch, -1, 0);
+                    if (resolveHighResolution(i + 1, msbCC, ((int)ch.msb[msbCC]) << 7, deliveries[count])){
+                        count++;
+                    }
+                }
+            }
+        }
+
+        for(int i = 0; i < count; i++){
+            deliverHighResolution(deliveries[i]);
         }
     }
 
+    void MidiReceiver::Delegate::receivedMessage(const unsigned char * bytes, std::size_t size, uint64_t time){
+        // data bytes (running status is resolved by the backend), system and uninteresting messages
+        if (size == 0 || handlers[bytes[0]] == nullptr){
+            metrics.midiRxIgnored.increment();
+            return;
+        }
+
+        metrics.midiRxMessages[midiTypeOf(bytes[0])].increment();
+
+        messageTime = time != 0 ? time : latencyNow();
+
+        handlers[bytes[0]](*this, bytes, size);
+    }
+
+    MidiReceiver * MidiReceiver::receivers[kMaxCaptureId] = {};
+    std::atomic<unsigned int> MidiReceiver::receiverCount{0};
+
     MidiReceiver::MidiReceiver(Delegate &delegate){
         this->midiReceiverDelegate = &delegate;
+
+        captureId = receiverCount.fetch_add(1, std::memory_order_relaxed);
+        if (captureId < kMaxCaptureId){
+            receivers[captureId] = this;
+        }
+    }
+
+    MidiReceiver::~MidiReceiver(){
+        stopPairTimer();
+
+        if (captureId < kMaxCaptureId){
+            receivers[captureId] = nullptr;
+        }
+    }
+
+    MidiReceiver * MidiReceiver::byCaptureId(unsigned int id){
+        if (id < kMaxCaptureId){
+            return receivers[id];
+        }
+        return nullptr;
+    }
+
+    std::atomic<Reactor*> MidiReceiver::reactor{nullptr};
+
+    void MidiReceiver::setReactor(Reactor * reactor){
+        MidiReceiver::reactor.store(reactor, std::memory_order_release);
+    }
+
+    void MidiReceiver::received(const libremidi::message& message){
+        // drop what the delegate does not handle before capturing or handing it over
+        if (message.bytes.empty() || !midiReceiverDelegate->handles(message.bytes[0])){
+            metrics.midiRxIgnored.increment();
+            return;
+        }
+
+        Reactor * r = reactor.load(std::memory_order_acquire);
+
+        if (r == nullptr){
+            inject(message);
+        } else if (!r->post(deliver, this, message.bytes.data(), message.bytes.size())){
+            LISA_LOG(LogLevelDebug, "MIDI message not delivered (%d bytes)", (int)message.bytes.size());
+        }
+    }
+
+    void MidiReceiver::deliver(void * receiver, const Reactor::Task & task){
+        libremidi::message message;
+        message.bytes.assign(task.data, task.data + task.size);
+
+        static_cast<MidiReceiver*>(receiver)->inject(message);
+    }
+
+    void MidiReceiver::inject(const libremidi::message& message){
+        capture(CaptureMidiIn, (uint8_t)captureId, message.bytes.data(), message.bytes.size());
+
+        // whatever a single message triggers is sent in one go
+        LisaControllerProxy::TxBatchScope batch;
+
+        // the ingress tag carries the backend's timestamp (also if handed over by the reactor)
+        uint64_t time = currentIngress != 0 ? ingressTime(currentIngress) : (uint64_t)message.timestamp;
+
+        midiReceiverDelegate->receivedMessage(message.bytes.data(), message.bytes.size(), time);
+    }
+
+    void MidiReceiver::startPairTimer(){
+        if (midiReceiverDelegate->highResolution == nullptr || pairThread != nullptr || pairTimer != -1){
+            return;
+        }
+
+        Reactor * r = reactor.load(std::memory_order_acquire);
+
+        if (r != nullptr){
+            // twice per timeout, so an MSB waits kPairTimeout to 1.5 * kPairTimeout at most
+            pairTimer = r->addTimer(std::chrono::microseconds(Delegate::kPairTimeout / 2000), [this](){
+                LisaControllerProxy::TxBatchScope batch;
+                midiReceiverDelegate->expireHighResolution(latencyNow());
+            });
+            if (pairTimer != -1){
+                pairReactor = r;
+                return;
+            }
+            LISA_LOG(LogLevelError, "Could not add MIDI pair timer to reactor, using a thread");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(midiReceiverDelegate->highResolution->mutex);
+            midiReceiverDelegate->highResolution->timerStop = false;
+        }
+
+        pairThread = new std::thread([this](){
+            runPairTimer();
+        });
+    }
+
+    void MidiReceiver::stopPairTimer(){
+        if (pairTimer != -1){
+            pairReactor->removeTimer(pairTimer);
+            pairTimer = -1;
+            pairReactor = nullptr;
+        }
+
+        if (pairThread != nullptr){
+            Delegate::HighResolutionState & state = *midiReceiverDelegate->highResolution;
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.timerStop = true;
+                state.timerWake.notify_one();
+            }
+
+            pairThread->join();
+            delete pairThread;
+            pairThread = nullptr;
+        }
+    }
+
+    void MidiReceiver::runPairTimer(){
+        Delegate::HighResolutionState & state = *midiReceiverDelegate->highResolution;
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+
+        while(!state.timerStop){
+            // nothing held back since the last look: sleep until something is (rather than ticking along)
+            if (state.pendingCount.load(std::memory_order_relaxed) == 0 && !state.pendingSet){
+                state.timerIdle = true;
+                state.timerWake.wait(lock, [&](){ return state.timerStop || !state.timerIdle; });
+                continue;
+            }
+            state.pendingSet = false;
+
+            state.timerWake.wait_for(lock, std::chrono::nanoseconds(Delegate::kPairTimeout / 2));
+            if (state.timerStop){
+                break;
+            }
+
+            lock.unlock();
+            {
+                LisaControllerProxy::TxBatchScope batch;
+                midiReceiverDelegate->expireHighResolution(latencyNow());
+            }
+            lock.lock();
+        }
+
+        state.timerIdle = false;
+    }
+
+    // time (see latencyNow()) the backend received the message at
+    static uint64_t arrivalTime(const libremidi::message& message){
+        uint64_t now = latencyNow();
+
+        // no or a bogus timestamp (the backend clock should be the same as ours)
+        if (message.timestamp <= 0 || now < (uint64_t)message.timestamp){
+            return now;
+        }
+
+        return (uint64_t)message.timestamp;
     }
 
     MidiReceiver_Single_Impl::MidiReceiver_Single_Impl(Delegate &delegate) :
             MidiReceiver(delegate),
             midiIn({
                 .on_message= [&](const libremidi::message& message) {
-                    midiReceiverDelegate->receivedMessage(message);
-                }
+                    IngressScope ingress(makeIngressTag(LatencySourceMidi, arrivalTime(message)));
+                    received(message);
+                },
+                .timestamps = libremidi::timestamp_mode::SystemMonotonic
             }){
         // do nothing
     }
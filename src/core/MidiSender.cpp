@@ -18,23 +18,134 @@
 
 #include "MidiSender.h"
 
+#include "Metrics.h"
 #include "log.h"
 #include <iostream>
 
 namespace LisaDeskbridge {
 
+    MidiSender_Single_Impl::MidiSender_Single_Impl(){
+        for(std::size_t i = 0; i < 16 * 128; i++){
+            ccValues[i].store(0, std::memory_order_relaxed);
+        }
+        for(std::size_t i = 0; i < 16 * 128 / 64; i++){
+            ccDirty[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    MidiSender_Single_Impl::~MidiSender_Single_Impl(){
+        stopOutput();
+    }
+
+    void MidiSender_Single_Impl::startOutput(unsigned int rate, Reactor * reactor){
+        assert(rate <= kOutputRateMax);
+
+        if (rate == 0 || outputStarted.load(std::memory_order_acquire)){
+            return;
+        }
+
+        if (reactor != nullptr){
+            outputReactor = reactor;
+            outputTimer = reactor->addTimer(std::chrono::microseconds(1000000 / rate), [this](){
+                flushOutput();
+            });
+        } else {
+            outputTask.start(std::chrono::microseconds(1000000 / rate), [this](){
+                flushOutput();
+            });
+        }
+
+        outputStarted.store(true, std::memory_order_release);
+    }
+
+    void MidiSender_Single_Impl::stopOutput(){
+        if (!outputStarted.load(std::memory_order_acquire)){
+            return;
+        }
+
+        outputTask.stop();
+
+        if (outputTimer != -1){
+            outputReactor->removeTimer(outputTimer);
+            outputTimer = -1;
+            outputReactor = nullptr;
+        }
+
+        // send anything left over, while senders still queue (rather than sending concurrently)
+        flushOutput();
+
+        outputStarted.store(false, std::memory_order_release);
+    }
+
+    void MidiSender_Single_Impl::flushOutput(){
+        // once the port is gone, whatever is pending is of no use anymore
+        bool open = midiOut.is_port_open();
+
+        while(outputQueue.pop([&](Message & message){
+            if (open){
+                sendNow(message.bytes, message.size);
+            }
+        })){
+            // until empty
+        }
+
+        for(std::size_t w = 0; w < 16 * 128 / 64; w++){
+            uint64_t bits = ccDirty[w].exchange(0, std::memory_order_acq_rel);
+
+            while(bits){
+                int b = __builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                std::size_t i = w * 64 + b;
+
+                unsigned char bytes[3] = {
+                        (unsigned char)((int)libremidi::message_type::CONTROL_CHANGE | (i / 128)),
+                        (unsigned char)(i % 128),
+                        ccValues[i].load(std::memory_order_relaxed)
+                };
+
+                if (open){
+                    sendNow(bytes, sizeof(bytes));
+                }
+            }
+        }
+    }
+
+    void MidiSender_Single_Impl::send(unsigned char status, unsigned char data1, unsigned char data2, uint8_t size){
+        if (!outputStarted.load(std::memory_order_acquire)){
+            if (!midiOut.is_port_open()){
+                return;
+            }
+            unsigned char bytes[3] = {status, data1, data2};
+            sendNow(bytes, size);
+            return;
+        }
+
+        if (!outputQueue.push([&](Message & message){
+            message.size = size;
+            message.bytes[0] = status;
+            message.bytes[1] = data1;
+            message.bytes[2] = data2;
+        })){
+            metrics.midiTxDropped.increment();
+            LISA_LOG(LogLevelDebug, "MIDI output queue full, dropping message (status %02x)", status);
+        }
+    }
+
+    void MidiSender_Single_Impl::sendNow(const unsigned char * bytes, std::size_t size){
+        metrics.midiTxMessages.increment();
+
+        midiOut.send_message(bytes, size);
+    }
+
     void MidiSender_Single_Impl::sendNoteOn(int channel, int note, int velocity) {
         assert(0 <= channel && channel <= 15);
         assert(0 <= note && note <= 127);
         assert(0 <= velocity && velocity <= 127);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
-
-        log(LogLevelDebug,"TX midi note on ch(%d) note(%d) vel(%d)", channel, note, velocity);
+        LISA_LOG(LogLevelDebug,"TX midi note on ch(%d) note(%d) vel(%d)", channel, note, velocity);
 
-        midiOut.send_message( ((int)libremidi::message_type::NOTE_ON | channel), note, velocity);
+        send((int)libremidi::message_type::NOTE_ON | channel, note, velocity);
     }
 
     void MidiSender_Single_Impl::sendNoteOff(int channel, int note, int velocity) {
@@ -42,13 +153,9 @@ namespace LisaDeskbridge {
         assert(0 <= note && note <= 127);
         assert(0 <= velocity && velocity <= 127);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
+        LISA_LOG(LogLevelDebug,"TX midi note off ch(%d) note(%d) vel(%d)", channel, note, velocity);
 
-        log(LogLevelDebug,"TX midi note off ch(%d) note(%d) vel(%d)", channel, note, velocity);
-
-        midiOut.send_message( ((int)libremidi::message_type::NOTE_OFF | channel), note, velocity);
+        send((int)libremidi::message_type::NOTE_OFF | channel, note, velocity);
     }
 
     void MidiSender_Single_Impl::sendControlChange(int channel, int cc, int value){
@@ -56,61 +163,66 @@ namespace LisaDeskbridge {
         assert(0 <= cc && cc <= 127);
         assert(0 <= value && value <= 127);
 
-        if (!midiOut.is_port_open()){
+        LISA_LOG(LogLevelDebug,"TX midi cc ch(%d) cc(%d) val(%d)", channel, cc, value);
+
+        send((int)libremidi::message_type::CONTROL_CHANGE | channel, cc, value);
+    }
+
+    void MidiSender_Single_Impl::sendFeedbackControlChange(int channel, int cc, int value){
+        assert(0 <= channel && channel <= 15);
+        assert(0 <= cc && cc <= 127);
+        assert(0 <= value && value <= 127);
+
+        LISA_LOG(LogLevelDebug,"TX midi feedback cc ch(%d) cc(%d) val(%d)", channel, cc, value);
+
+        if (!outputStarted.load(std::memory_order_acquire)){
+            send((int)libremidi::message_type::CONTROL_CHANGE | channel, cc, value);
             return;
         }
 
-        log(LogLevelDebug,"TX midi cc ch(%d) cc(%d) val(%d)", channel, cc, value);
+        // only the latest value is sent on the next flush
+        std::size_t i = channel * 128 + cc;
+        uint64_t bit = ((uint64_t)1) << (i % 64);
 
-        midiOut.send_message( ((int)libremidi::message_type::CONTROL_CHANGE | channel), cc, value);
+        ccValues[i].store(value, std::memory_order_relaxed);
+
+        if (ccDirty[i / 64].fetch_or(bit, std::memory_order_acq_rel) & bit){
+            metrics.midiTxSuperseded.increment();
+        }
     }
+
     void MidiSender_Single_Impl::sendAftertouch(int channel, int note, int pressure) {
         assert(0 <= channel && channel <= 15);
         assert(0 <= note && note <= 127);
         assert(0 <= pressure && pressure <= 127);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
-
-        midiOut.send_message( ((int)libremidi::message_type::POLY_PRESSURE | channel), note, pressure);
+        send((int)libremidi::message_type::POLY_PRESSURE | channel, note, pressure);
     }
 
     void MidiSender_Single_Impl::sendProgramChange(int channel, int program) {
         assert(0 <= channel && channel <= 15);
         assert(0 <= program && program <= 127);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
-
-        midiOut.send_message( ((int)libremidi::message_type::PROGRAM_CHANGE | channel), program);
+        send((int)libremidi::message_type::PROGRAM_CHANGE | channel, program, 0, 2);
     }
 
     void MidiSender_Single_Impl::sendChannelPressure(int channel, int pressure) {
         assert(0 <= channel && channel <= 15);
         assert(0 <= pressure && pressure <= 127);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
-        midiOut.send_message( ((int)libremidi::message_type::AFTERTOUCH | channel), pressure);
+        send((int)libremidi::message_type::AFTERTOUCH | channel, pressure, 0, 2);
     }
 
     void MidiSender_Single_Impl::sendPitchBend(int channel, int bend) {
         assert(0 <= channel && channel <= 15);
         assert(0 <= bend && bend <= 16384);
 
-        if (!midiOut.is_port_open()){
-            return;
-        }
-
         // least significant bytes first...
         int b1 = bend & 0b01111111;
         int b2 = (bend >> 7) & 0b01111111;
 
-        midiOut.send_message( ((int)libremidi::message_type::POLY_PRESSURE | channel), b1, b2);
+        send((int)libremidi::message_type::POLY_PRESSURE | channel, b1, b2);
     }
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,333 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "OscAddresses.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace LisaDeskbridge {
+
+    static constexpr const char * kSourceAddressFormats[SourceAddressCount] = {
+            kMsgSetSourceControlPan,
+            kMsgSetSourceControlWidth,
+            kMsgSetSourceControlDistance,
+            kMsgSetSourceControlElevation,
+            kMsgSetSourceControlAuxSend,
+
+            kMsgSetSourcePan,
+            kMsgSetSourceWidth,
+            kMsgSetSourceDistance,
+            kMsgSetSourceElevation,
+            kMsgSetSourcePanSpread,
+            kMsgSetSourceAuxSend,
+
+            kMsgSetSourceAllParameters,
+
+            kMsgSetSourceRelativePan,
+            kMsgSetSourceRelativeWidth,
+            kMsgSetSourceRelativeDistance,
+            kMsgSetSourceRelativeElevation,
+            kMsgSetSourceRelativePanSpread,
+            kMsgSetSourceRelativeAuxSend,
+
+            kMsgSetSourceSolo,
+            kMsgSetSourceStaticDelayValue,
+            kMsgSnapSourceToSpeaker,
+
+            kMsgSetSourceOptGain,
+            kMsgSetSourceOptHpf,
+            kMsgSetSourceOptDelayEnabled,
+            kMsgSetSourceOptDelayMode,
+            kMsgSetSourceOptReverbEarly,
+            kMsgSetSourceOptReverbCluster,
+            kMsgSetSourceOptReverbLate,
+            kMsgSetSourceOptDirectSound,
+
+            kMsgChangeSelectionOfSource,
+            kMsgSetSelectionToSource
+    };
+
+    static constexpr const char * kGroupAddressFormats[GroupAddressCount] = {
+            kMsgSetGroupPan,
+            kMsgSetGroupWidth,
+            kMsgSetGroupDistance,
+            kMsgSetGroupElevation,
+            kMsgSetGroupAuxSend,
+            kMsgSetGroupPanSpread,
+
+            kMsgSetGroupRelativePan,
+            kMsgSetGroupRelativeWidth,
+            kMsgSetGroupRelativeDistance,
+            kMsgSetGroupRelativeElevation,
+            kMsgSetGroupRelativeAuxSend,
+            kMsgSetGroupRelativePanSpread,
+
+            kMsgSetSelectionToGroup
+    };
+
+    static constexpr const char * kFxAddressFormats[FxAddressCount] = {
+            kMsgStartFx,
+            kMsgRestartFx,
+            kMsgStopFx
+    };
+
+    static constexpr const char * kUserFaderAddressFormats[UserFaderAddressCount] = {
+            kMsgSetUserFaderNGain,
+            kMsgSetUserFaderNPos,
+            kMsgSetUserFaderNMute
+    };
+
+    static constexpr const char * kDeviceAddressFormats[DeviceAddressCount] = {
+            kMsgRegisterDevice,
+            kMsgDeleteDevice,
+            kMsgSetDeviceName,
+            kMsgEnableSendingToDevice,
+            kMsgEnableReceivingFromDevice,
+            kMsgSetDeviceCoordFormat,
+            kMsgSetMasterGainControl
+    };
+
+    const OscAddressTable & OscAddressTable::instance(){
+        // initialized (thread-safe) on first use, which normally is the construction of the controller proxy
+        static const OscAddressTable table;
+        return table;
+    }
+
+    void OscAddressTable::expand(OscAddress & address, const char * format, unsigned int id){
+        std::memset(address.str, 0, sizeof(address.str));
+
+        int l = std::snprintf(address.str, sizeof(address.str), format, id);
+
+        // if this fails, OscAddress::kCapacity must be increased
+        assert(0 < l && l < (int)sizeof(address.str));
+        (void)l;
+    }
+
+    // Receive
+
+    static constexpr char kRxPrefix[]               = "/ext/";
+    static constexpr char kRxSourcePrefix[]         = "src/";
+    static constexpr char kRxMasterPrefix[]         = "master/";
+    static constexpr char kRxReverbPrefix[]         = "rev/master/";
+    static constexpr char kRxGain[]                 = "gain";
+    static constexpr char kRxFaderPos[]             = "faderpos";
+    static constexpr char kRxPong[]                 = "pong";
+
+    // max source id 96, anything longer definitely is invalid
+    static constexpr int kRxMaxIdDigits             = 3;
+
+    static RxAddress_t parseRxFader(const char * str, RxAddress_t gain, RxAddress_t faderPos){
+        if (std::strcmp(str, kRxGain) == 0){
+            return gain;
+        }
+        if (std::strcmp(str, kRxFaderPos) == 0){
+            return faderPos;
+        }
+        return RxAddressUnknown;
+    }
+
+    RxAddress parseRxAddress(const char * address){
+        static constexpr size_t kPrefixLen = sizeof(kRxPrefix) - 1;
+
+        RxAddress result = {RxAddressUnknown, 0};
+
+        assert(address != nullptr);
+
+        if (std::strncmp(address, kRxPrefix, kPrefixLen) != 0){
+            return result;
+        }
+
+        const char * p = address + kPrefixLen;
+
+        switch(*p){
+            case 's': {
+                if (std::strncmp(p, kRxSourcePrefix, sizeof(kRxSourcePrefix) - 1) != 0){
+                    return result;
+                }
+                p += sizeof(kRxSourcePrefix) - 1;
+
+                unsigned int id = 0;
+                int digits = 0;
+                while('0' <= *p && *p <= '9'){
+                    if (++digits > kRxMaxIdDigits){
+                        return result;
+                    }
+                    id = 10 * id + (*p - '0');
+                    p++;
+                }
+                if (digits == 0 || p[0] != '/' || p[1] == '\0' || p[2] != '\0'){
+                    return result;
+                }
+
+                switch(p[1]){
+                    case 'p': result.type = RxAddressSourcePan;         break;
+                    case 'w': result.type = RxAddressSourceWidth;       break;
+                    case 'd': result.type = RxAddressSourceDistance;    break;
+                    case 'e': result.type = RxAddressSourceElevation;   break;
+                    case 's': result.type = RxAddressSourceAuxSend;     break;
+                    default:
+                        return result;
+                }
+                result.id = id;
+                return result;
+            }
+
+            case 'm':
+                if (std::strncmp(p, kRxMasterPrefix, sizeof(kRxMasterPrefix) - 1) == 0){
+                    result.type = parseRxFader(p + sizeof(kRxMasterPrefix) - 1, RxAddressMasterGain, RxAddressMasterFaderPos);
+                }
+                return result;
+
+            case 'r':
+                if (std::strncmp(p, kRxReverbPrefix, sizeof(kRxReverbPrefix) - 1) == 0){
+                    result.type = parseRxFader(p + sizeof(kRxReverbPrefix) - 1, RxAddressReverbGain, RxAddressReverbFaderPos);
+                }
+                return result;
+
+            case 'p':
+                if (std::strcmp(p, kRxPong) == 0){
+                    result.type = RxAddressPong;
+                }
+                return result;
+
+            default:
+                return result;
+        }
+    }
+
+
+    // Classification
+
+    static const char * const kMessageClassNames[MessageClassCount] = {
+            "source_param",
+            "group_param",
+            "selection",
+            "snapshot",
+            "fader",
+            "flags",
+            "device",
+            "other"
+    };
+
+    const char * messageClassName(MessageClass_t cls){
+        assert(0 <= cls && cls < MessageClassCount);
+        return kMessageClassNames[cls];
+    }
+
+    static inline bool startsWith(const char * str, const char * prefix, size_t length){
+        return std::strncmp(str, prefix, length) == 0;
+    }
+
+#define STARTS_WITH(str, prefix) startsWith(str, prefix, sizeof(prefix) - 1)
+
+    MessageClass_t classifyAddress(const char * address){
+        assert(address != nullptr);
+
+        if (!STARTS_WITH(address, kRxPrefix)){
+            // headtracker
+            return MessageClassOther;
+        }
+
+        const char * p = address + sizeof(kRxPrefix) - 1;
+
+        switch(*p){
+            case 's':
+                if (STARTS_WITH(p, "src/") || STARTS_WITH(p, "selsrc/")){
+                    return MessageClassSourceParam;
+                }
+                if (STARTS_WITH(p, "sel/")){
+                    return MessageClassSelection;
+                }
+                if (STARTS_WITH(p, "snap/")){
+                    return MessageClassSnapshot;
+                }
+                // solo, spksnap
+                return MessageClassOther;
+            case 'g':
+                return STARTS_WITH(p, "grp/") ? MessageClassGroupParam : MessageClassOther;
+            case 'f':
+                if (STARTS_WITH(p, "flag/")){
+                    return MessageClassFlags;
+                }
+                if (STARTS_WITH(p, "fader")){
+                    return MessageClassFader;
+                }
+                // fx
+                return MessageClassOther;
+            case 'c':
+                return STARTS_WITH(p, "config/") ? MessageClassFlags : MessageClassOther;
+            case 'm':
+                return (STARTS_WITH(p, "master/") || STARTS_WITH(p, "mon/")) ? MessageClassFader : MessageClassOther;
+            case 'r':
+                // reverb presets are other
+                return STARTS_WITH(p, kRxReverbPrefix) ? MessageClassFader : MessageClassOther;
+            case 'd':
+                return STARTS_WITH(p, "device/") ? MessageClassDevice : MessageClassOther;
+            case 'p':
+                return STARTS_WITH(p, "ping") ? MessageClassDevice : MessageClassOther;
+            default:
+                return MessageClassOther;
+        }
+    }
+
+#undef STARTS_WITH
+
+
+    OscAddressTable::OscAddressTable(){
+
+        for(unsigned int src = 1; src <= kMaxSourceId; src++){
+            for(int a = 0; a < SourceAddressCount; a++){
+                expand(sources_[src-1][a], kSourceAddressFormats[a], src);
+            }
+        }
+
+        for(unsigned int grp = 1; grp <= kMaxGroupId; grp++){
+            for(int a = 0; a < GroupAddressCount; a++){
+                expand(groups_[grp-1][a], kGroupAddressFormats[a], grp);
+            }
+        }
+
+        for(unsigned int snapshot = 1; snapshot <= kMaxSnapshotId; snapshot++){
+            expand(snapshots_[snapshot-1], kMsgFireSnapshot, snapshot);
+        }
+
+        for(unsigned int reverb = 1; reverb <= kMaxReverbId; reverb++){
+            expand(reverbs_[reverb-1], kMsgLoadReverbPreset, reverb);
+        }
+
+        for(unsigned int fx = 1; fx <= kMaxFxId; fx++){
+            for(int a = 0; a < FxAddressCount; a++){
+                expand(fxs_[fx-1][a], kFxAddressFormats[a], fx);
+            }
+        }
+
+        for(unsigned int fader = 1; fader <= kMaxUserFader; fader++){
+            for(int a = 0; a < UserFaderAddressCount; a++){
+                expand(userFaders_[fader-1][a], kUserFaderAddressFormats[a], fader);
+            }
+        }
+
+        for(unsigned int device = 1; device <= kMaxDeviceId; device++){
+            for(int a = 0; a < DeviceAddressCount; a++){
+                expand(devices_[device-1][a], kDeviceAddressFormats[a], device);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,83 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PeriodicTask.h"
+
+#include <cassert>
+
+namespace LisaDeskbridge {
+
+    void PeriodicTask::start(std::chrono::microseconds period, Callback callback){
+        assert(period.count() > 0);
+        assert(callback != nullptr);
+
+        if (isRunning()){
+            return;
+        }
+
+        stopRequested = false;
+
+        thread = new std::thread([this](std::chrono::microseconds period, Callback callback){
+            run(period, callback);
+        }, period, callback);
+    }
+
+    void PeriodicTask::stop(){
+        if (!isRunning()){
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        cv.notify_all();
+
+        thread->join();
+
+        delete thread;
+        thread = nullptr;
+    }
+
+    void PeriodicTask::run(std::chrono::microseconds period, Callback callback){
+
+        auto next = std::chrono::steady_clock::now() + period;
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while(!stopRequested){
+
+            if (cv.wait_until(lock, next, [this]{ return stopRequested; })){
+                break;
+            }
+
+            lock.unlock();
+            callback();
+            lock.lock();
+
+            next += period;
+
+            // if we fell behind (system suspended, overly long callback) do not try to catch up
+            auto now = std::chrono::steady_clock::now();
+            if (next < now){
+                next = now + period;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,254 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Reactor.h"
+#include "Latency.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace LisaDeskbridge {
+
+#if defined(__linux__)
+
+    bool Reactor::open(){
+        if (isOpen()){
+            return true;
+        }
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1){
+            LISA_LOG(LogLevelError, "epoll_create1 failed: %s", strerror(errno));
+            return false;
+        }
+
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd == -1){
+            LISA_LOG(LogLevelError, "eventfd failed: %s", strerror(errno));
+            close();
+            return false;
+        }
+
+        stopRequested = false;
+        wakePending = false;
+
+        return watch(wakeFd, [this](){
+            uint64_t count;
+            (void)read(wakeFd, &count, sizeof(count));
+            runTasks();
+        });
+    }
+
+    void Reactor::close(){
+        if (!isOpen()){
+            return;
+        }
+
+        for(auto & w : watches){
+            delete w.second;
+        }
+        watches.clear();
+        for(Watch * w : removedWatches){
+            delete w;
+        }
+        removedWatches.clear();
+
+        if (wakeFd != -1){
+            ::close(wakeFd);
+            wakeFd = -1;
+        }
+
+        ::close(epollFd);
+        epollFd = -1;
+    }
+
+    bool Reactor::watch(int fd, Callback callback){
+        Watch * w = new Watch{fd, callback, false};
+
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = w;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1){
+            LISA_LOG(LogLevelError, "epoll_ctl failed: %s", strerror(errno));
+            delete w;
+            return false;
+        }
+
+        watches[fd] = w;
+
+        return true;
+    }
+
+    void Reactor::unwatch(int fd){
+        auto it = watches.find(fd);
+        if (it == watches.end()){
+            return;
+        }
+
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+        // events of the current batch might still refer to it
+        it->second->removed = true;
+        removedWatches.push_back(it->second);
+        watches.erase(it);
+    }
+
+    int Reactor::addTimer(std::chrono::microseconds period, Callback callback){
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd == -1){
+            LISA_LOG(LogLevelError, "timerfd_create failed: %s", strerror(errno));
+            return -1;
+        }
+
+        struct itimerspec spec;
+        spec.it_interval.tv_sec = period.count() / 1000000;
+        spec.it_interval.tv_nsec = (period.count() % 1000000) * 1000;
+        spec.it_value = spec.it_interval;
+
+        if (timerfd_settime(fd, 0, &spec, nullptr) == -1 || !watch(fd, [fd, callback](){
+                uint64_t expirations;
+                // if we fell behind do not try to catch up
+                if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)){
+                    callback();
+                }
+            })){
+            ::close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    void Reactor::removeTimer(int timer){
+        if (timer == -1){
+            return;
+        }
+        unwatch(timer);
+        ::close(timer);
+    }
+
+    bool Reactor::post(TaskFunction function, void * context, const void * data, std::size_t size){
+        if (kTaskDataSize < size){
+            tasksDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        bool queued = tasks.push([&](Task & task){
+            task.run = function;
+            task.context = context;
+            task.ingress = currentIngress;
+            task.size = (uint8_t)size;
+            std::memcpy(task.data, data, size);
+        });
+
+        if (!queued){
+            tasksDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // pairs with the fence in runTasks(): either we see the loop has not yet cleared wakePending or it sees our task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // only the first task since the loop last woke up needs to wake it (saves a syscall per task)
+        if (!wakePending.exchange(true, std::memory_order_relaxed)){
+            uint64_t one = 1;
+            (void)write(wakeFd, &one, sizeof(one));
+        }
+
+        return true;
+    }
+
+    void Reactor::runTasks(){
+        wakePending.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        while(tasks.pop([](Task & task){
+            IngressScope ingress(task.ingress);
+            task.run(task.context, task);
+        })){
+            // until drained
+        }
+    }
+
+    void Reactor::run(){
+        static constexpr int kMaxEvents = 16;
+        struct epoll_event events[kMaxEvents];
+
+        while(!stopRequested.load(std::memory_order_relaxed)){
+            int n = epoll_wait(epollFd, events, kMaxEvents, -1);
+
+            if (n == -1){
+                if (errno == EINTR){
+                    continue;
+                }
+                LISA_LOG(LogLevelError, "epoll_wait failed: %s", strerror(errno));
+                break;
+            }
+
+            for(int i = 0; i < n; i++){
+                Watch * w = (Watch*)events[i].data.ptr;
+                if (!w->removed){
+                    w->callback();
+                }
+            }
+
+            for(Watch * w : removedWatches){
+                delete w;
+            }
+            removedWatches.clear();
+        }
+    }
+
+    void Reactor::stop(){
+        stopRequested = true;
+
+        uint64_t one = 1;
+        (void)write(wakeFd, &one, sizeof(one));
+    }
+
+#else // !__linux__
+
+    bool Reactor::open(){
+        LISA_LOG(LogLevelError, "Reactor is only supported on Linux");
+        return false;
+    }
+
+    void Reactor::close(){}
+    bool Reactor::watch(int fd, Callback callback){ return false; }
+    void Reactor::unwatch(int fd){}
+    int Reactor::addTimer(std::chrono::microseconds period, Callback callback){ return -1; }
+    void Reactor::removeTimer(int timer){}
+    bool Reactor::post(TaskFunction function, void * context, const void * data, std::size_t size){ return false; }
+    void Reactor::runTasks(){}
+    void Reactor::run(){}
+    void Reactor::stop(){}
+
+#endif
+
+}
@@ -0,0 +1,54 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RelativeCoalescer.h"
+
+namespace LisaDeskbridge {
+
+    RelativeCoalescer::RelativeCoalescer(){
+        for(std::size_t i = 0; i < kSlotCount; i++){
+            sums[i].store(0.0f, std::memory_order_relaxed);
+            ingress[i].store(0, std::memory_order_relaxed);
+        }
+        for(std::size_t i = 0; i < kDirtyWordCount; i++){
+            dirty[i].store(0, std::memory_order_relaxed);
+        }
+        pending.store(false, std::memory_order_release);
+    }
+
+    void RelativeCoalescer::add(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float delta, uint64_t ingressTag){
+        std::size_t slot = slotOf(target, id, param);
+
+        if (ingressTag != 0){
+            // keep the oldest
+            uint64_t none = 0;
+            ingress[slot].compare_exchange_strong(none, ingressTag, std::memory_order_relaxed);
+        }
+
+        // std::atomic<float>::fetch_add is C++20 only
+        float sum = sums[slot].load(std::memory_order_relaxed);
+        while(!sums[slot].compare_exchange_weak(sum, sum + delta, std::memory_order_acq_rel, std::memory_order_relaxed)){
+            // retry with updated sum
+        }
+
+        dirty[slot / 64].fetch_or(((uint64_t)1) << (slot % 64), std::memory_order_acq_rel);
+
+        pending.store(true, std::memory_order_release);
+    }
+
+}
@@ -0,0 +1,125 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Transport.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace LisaDeskbridge {
+
+    UdpFanoutTransport::UdpFanoutTransport(){
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd == -1){
+            throw std::runtime_error("Could not open UDP transmit socket");
+        }
+    }
+
+    UdpFanoutTransport::~UdpFanoutTransport(){
+        close(fd);
+    }
+
+    bool UdpFanoutTransport::addTarget(const char * address, unsigned short port){
+        if (targetCount >= kMaxTargets){
+            return false;
+        }
+
+        struct sockaddr_in & target = targets[targetCount];
+        std::memset(&target, 0, sizeof(target));
+        target.sin_family = AF_INET;
+        target.sin_port = htons(port);
+        if (inet_aton(address, &target.sin_addr) != 1){
+            return false;
+        }
+
+        targetCount++;
+
+        return true;
+    }
+
+    void UdpFanoutTransport::send(const char * data, std::size_t size){
+        Buffer buffer = {data, size};
+        sendBatch(&buffer, 1);
+    }
+
+    std::size_t UdpFanoutTransport::sendBatch(const Buffer * buffers, std::size_t count){
+        std::size_t syscalls = 0;
+
+#if defined(__linux__)
+        struct iovec iovs[kMaxBatch];
+        struct mmsghdr msgs[kMaxBatch * kMaxTargets];
+
+        while(count > 0){
+            std::size_t n = count < kMaxBatch ? count : kMaxBatch;
+
+            // datagram by datagram (to all targets), such that the order is kept for every target
+            std::size_t m = 0;
+            for(std::size_t i = 0; i < n; i++){
+                iovs[i].iov_base = (void*)buffers[i].data;
+                iovs[i].iov_len = buffers[i].size;
+
+                for(std::size_t t = 0; t < targetCount; t++, m++){
+                    std::memset(&msgs[m], 0, sizeof(msgs[m]));
+                    msgs[m].msg_hdr.msg_name = &targets[t];
+                    msgs[m].msg_hdr.msg_namelen = sizeof(targets[t]);
+                    msgs[m].msg_hdr.msg_iov = &iovs[i];
+                    msgs[m].msg_hdr.msg_iovlen = 1;
+                }
+            }
+
+            // sendmmsg() stops at the first failing message, carry on with the ones after it
+            std::size_t sent = 0;
+            while(sent < m){
+                int r = sendmmsg(fd, msgs + sent, m - sent, 0);
+                syscalls++;
+                if (r <= 0){
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                    r = 1;
+                }
+                sent += r;
+            }
+
+            buffers += n;
+            count -= n;
+        }
+#else
+        for(std::size_t i = 0; i < count; i++){
+            for(std::size_t t = 0; t < targetCount; t++){
+                syscalls++;
+                if (sendto(fd, buffers[i].data, buffers[i].size, 0, (struct sockaddr*)&targets[t], sizeof(targets[t])) == -1){
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+#endif
+
+        return syscalls;
+    }
+
+    UdpTransport::UdpTransport(const char * address, unsigned short port){
+        if (!addTarget(address, port)){
+            throw std::invalid_argument("Invalid L-ISA Controller address");
+        }
+    }
+
+}
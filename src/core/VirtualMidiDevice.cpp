@@ -27,6 +27,8 @@ namespace LisaDeskbridge {
     }
 
     void VirtualMidiDevice::start(std::basic_string_view<char> portName){
+        startPairTimer();
+
         midiIn.open_virtual_port(portName);
         midiOut.open_virtual_port(portName);
     }
@@ -34,6 +36,8 @@ namespace LisaDeskbridge {
     void VirtualMidiDevice::stop(){
         midiOut.close_port();
         midiIn.close_port();
+
+        stopPairTimer();
     }
 
 }
\ No newline at end of file
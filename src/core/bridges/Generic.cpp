@@ -30,6 +30,17 @@ namespace LisaDeskbridge {
                 virtualMidiDevice(*this),
                 midiClient(*this)
         {
+                ignoreAll();
+                handle(MidiTypeNoteOn);
+                handle(MidiTypeNoteOff);
+                handle(MidiTypeControlChange);
+
+                if (hiresFaders_){
+                    for(int cc = 1; cc <= 5; cc++){
+                        assembleControlChange14(cc, 2);
+                    }
+                }
+
                 if (opts.contains("midiin")){
                     midiInPortName = opts["midiin"];
                 }
@@ -39,10 +50,11 @@ namespace LisaDeskbridge {
         }
 
         bool Generic::startVirtualMidiDevice(){
-            log(LogLevelInfo, "Starting virtual MIDI Device '%s' .." , VirtualMidiDevice::kDefaultPortName);
+            LISA_LOG(LogLevelInfo, "Starting virtual MIDI Device '%s' .." , VirtualMidiDevice::kDefaultPortName);
 
             try {
                 virtualMidiDevice.start();
+                virtualMidiDevice.startOutput(midiOutRate_, reactor());
             } catch (const std::exception & e){
                 std::cerr << e.what() << std::endl;
                 return false;
@@ -52,22 +64,24 @@ namespace LisaDeskbridge {
         }
 
         void Generic::stopVirtualMidiDevice(){
-            log(LogLevelInfo, "Stopping virtual MIDI Device .." );
+            LISA_LOG(LogLevelInfo, "Stopping virtual MIDI Device .." );
+            virtualMidiDevice.stopOutput();
             virtualMidiDevice.stop();
         }
 
         bool Generic::startMidiClient() {
             if (midiInPortName.length() == 0){
 //                error("No midi in- or out-port defined!");
-                log(LogLevelInfo, "Not using MIDI Client." );
+                LISA_LOG(LogLevelInfo, "Not using MIDI Client." );
                 return true;
             }
 
-            log(LogLevelInfo, "Starting MIDI Client.." );
+            LISA_LOG(LogLevelInfo, "Starting MIDI Client.." );
             try {
                 midiClient.start(midiInPortName, midiOutPortName);
+                midiClient.startOutput(midiOutRate_, reactor());
             } catch (const std::exception & e){
-                log(LogLevelError, "starting MIDI Client: %s", e.what() );
+                LISA_LOG(LogLevelError, "starting MIDI Client: %s", e.what() );
                 return false;
             }
 
@@ -79,7 +93,8 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelInfo, "Stopping MIDI Client.." );
+            LISA_LOG(LogLevelInfo, "Stopping MIDI Client.." );
+            midiClient.stopOutput();
             midiClient.stop();
         }
 
@@ -120,7 +135,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug, "NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             if (channel == 1){ // select source
                 if (!isValidDeviceId(note)){
@@ -157,7 +172,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug, "NOTE OFF ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "NOTE OFF ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
         }
         void Generic::receivedControlChange(int channel, int cc, int value){
@@ -166,29 +181,45 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug,"CC ch(%d) cc(%d) value(%d)", channel, cc, value);
+            LISA_LOG(LogLevelDebug,"CC ch(%d) cc(%d) value(%d)", channel, cc, value);
 
             if (channel == 1){
 
             }
             else if (channel == 2){ // faders
-                if (cc == 1){
-                    lisaControllerProxy_.setMasterFaderPos((float)value / 127.0);
-                }
-                else if (cc == 2){
-                    lisaControllerProxy_.setReverbFaderPos((float)value / 127.0);
-                }
-                else if (cc == 3){
-                    lisaControllerProxy_.setMonitorFaderPos((float)value / 127.0);
-                }
-                else if (cc == 4){
-                    lisaControllerProxy_.setUserFaderNPos(1, (float)value / 127.0);
-                }
-                else if (cc == 5){
-                    lisaControllerProxy_.setUserFaderNPos(2, (float)value / 127.0);
-                }
+                faderChange(cc, (float)value / 127.0);
+            }
+
+        }
+        void Generic::receivedControlChange14(int channel, int cc, int value){
+            // only process if completely started
+            if (state != State_Started){
+                return;
+            }
+
+            LISA_LOG(LogLevelDebug,"CC14 ch(%d) cc(%d) value(%d)", channel, cc, value);
+
+            if (channel == 2){ // faders
+                faderChange(cc, (float)value / 16383.0);
             }
+        }
 
+        void Generic::faderChange(int cc, float pos){
+            if (cc == 1){
+                lisaControllerProxy_.setMasterFaderPos(pos);
+            }
+            else if (cc == 2){
+                lisaControllerProxy_.setReverbFaderPos(pos);
+            }
+            else if (cc == 3){
+                lisaControllerProxy_.setMonitorFaderPos(pos);
+            }
+            else if (cc == 4){
+                lisaControllerProxy_.setUserFaderNPos(1, pos);
+            }
+            else if (cc == 5){
+                lisaControllerProxy_.setUserFaderNPos(2, pos);
+            }
         }
 
 
@@ -202,8 +233,8 @@ namespace LisaDeskbridge {
 
             int value = (int)(127.0 * pos);
 
-            virtualMidiDevice.sendControlChange(1, 0, value);
-            midiClient.sendControlChange(1,0,value);
+            virtualMidiDevice.sendFeedbackControlChange(1, 0, value);
+            midiClient.sendFeedbackControlChange(1,0,value);
         }
 
         void Generic::receivedReverbFaderPos(float pos){
@@ -214,8 +245,8 @@ namespace LisaDeskbridge {
 
             int value = (int)(127.0 * pos);
 
-            virtualMidiDevice.sendControlChange(1,1,value);
-            midiClient.sendControlChange(1,1,value);
+            virtualMidiDevice.sendFeedbackControlChange(1,1,value);
+            midiClient.sendFeedbackControlChange(1,1,value);
         }
     }
 }
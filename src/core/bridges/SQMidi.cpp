@@ -40,7 +40,7 @@ namespace LisaDeskbridge {
         }
 
         bool SQMidi::startMixingStationVirtualMidiDevice(){
-            log(LogLevelInfo, "Starting virtual MIDI Device '%s' for channel selection ..",VirtualMidiDevice::kDefaultPortName );
+            LISA_LOG(LogLevelInfo, "Starting virtual MIDI Device '%s' for channel selection ..",VirtualMidiDevice::kDefaultPortName );
 
             try {
                 mixingStationVirtualMidiDevice.start();
@@ -53,16 +53,17 @@ namespace LisaDeskbridge {
         }
 
         void SQMidi::stopMixingStationVirtualMidiDevice(){
-            log(LogLevelInfo, "Stopping virtual MIDI Device for channel selection ..");
+            LISA_LOG(LogLevelInfo, "Stopping virtual MIDI Device for channel selection ..");
 
             mixingStationVirtualMidiDevice.stop();
         }
 
         bool SQMidi::startSQMidiControlClient() {
-            log(LogLevelInfo, "Starting MIDI Client..");
+            LISA_LOG(LogLevelInfo, "Starting MIDI Client..");
 
             try {
                 sqMidiControlClient.start(midiInPortName, midiOutPortName);
+                sqMidiControlClient.startOutput(midiOutRate_, reactor());
             } catch (const std::exception & e){
                 std::cerr << e.what() << std::endl;
                 return false;
@@ -72,8 +73,9 @@ namespace LisaDeskbridge {
         }
 
         void SQMidi::stopSQMidiControlClient() {
-            log(LogLevelInfo, "Stopping MIDI Client..");
+            LISA_LOG(LogLevelInfo, "Stopping MIDI Client..");
 
+            sqMidiControlClient.stopOutput();
             sqMidiControlClient.stop();
         }
 
@@ -107,7 +109,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug,"MIX NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug,"MIX NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             // select source (channel == 1 (valid source range)
             if (channel == 1 && 1 <= note && note <= 96){
@@ -173,7 +175,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug, "SQ NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "SQ NOTE ON ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             if (channel == 1 && note == 1){
                 sq6->softBtn1 = ButtonState_Pressed;
@@ -224,7 +226,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug, "SQ NOTE OFF ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "SQ NOTE OFF ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             if (channel == 1 && note == 1){
                 sq6->softBtn1 = ButtonState_Released;
@@ -245,74 +247,88 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelDebug,"SQ CC ch(%d) cc(%d) value(%d)", channel, cc, value);
+            LISA_LOG(LogLevelDebug,"SQ CC ch(%d) cc(%d) value(%d)", channel, cc, value);
 
             if (channel == 1){
                 if (1 <= cc && cc <= 8){
                     // turn a signed 7-bit value into a proper int value we can work with
                     int i = (int)(signed char)(value | ((value & 0b01000000) << 1));
-                    float r = (float)i * kDefaultRelativeStepSize;
                     if (cc == 1){
                         if (sq6->softBtn4 == ButtonState_Released) {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativePan(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativePan(sq6->relativeStep(RelativePan, i, getMessageTime()));
                         } else {
                             // do nothing
                         }
                     } else if (cc == 2){
                         if (sq6->softBtn4 == ButtonState_Released) {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativePanSpread(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativePanSpread(sq6->relativeStep(RelativePanSpread, i, getMessageTime()));
                         } else {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeWidth(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeWidth(sq6->relativeStep(RelativeWidth, i, getMessageTime()));
                         }
                     } else if (cc == 3){
                         if (sq6->softBtn4 == ButtonState_Released) {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeDistance(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeDistance(sq6->relativeStep(RelativeDistance, i, getMessageTime()));
                         } else {
                         }
                     } else if (cc == 4){
                         if (sq6->softBtn4 == ButtonState_Released) {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeElevation(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeElevation(sq6->relativeStep(RelativeElevation, i, getMessageTime()));
                         } else {
-                            sq6->lisaControllerProxy_.setSelectedSourceRelativeAuxSend(r);
+                            sq6->lisaControllerProxy_.setSelectedSourceRelativeAuxSend(sq6->relativeStep(RelativeAuxSend, i, getMessageTime()));
                         }
                     } else if (cc == 5){
                         // not used
                     } else if (cc == 6){
                         if (sq6->softBtn4 == ButtonState_Released) {
-                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeWidth(r);
+                            sq6->lisaControllerProxy_.setSelectedSourcesRelativeWidth(sq6->relativeStep(RelativeWidth, i, getMessageTime()));
                     } else if (cc == 7){
                             // not used
                         }
                     } else if (cc == 8){
-                        sq6->lisaControllerProxy_.setSelectedSourceRelativeAuxSend(r);
+                        sq6->lisaControllerProxy_.setSelectedSourceRelativeAuxSend(sq6->relativeStep(RelativeAuxSend, i, getMessageTime()));
                     }
                 }
             } // channel == 1
             else if (channel == 2){
-                if (cc == 0){
-                    sq6->lisaControllerProxy_.setMasterFaderPos((float)value / 127.0);
-                }
-                else if (cc == 1){
-                    sq6->lisaControllerProxy_.setReverbFaderPos((float)value / 127.0);
-                }
-                else if (cc == 2){
-                    sq6->lisaControllerProxy_.setMonitorFaderPos((float)value / 127.0);
-                }
-                else if (cc == 3){
-                    sq6->lisaControllerProxy_.setUserFaderNPos(1, (float)value / 127.0);
-                }
-                else if (cc == 4){
-                    sq6->lisaControllerProxy_.setUserFaderNPos(2, (float)value / 127.0);
-                }
+                faderChange(cc, (float)value / 127.0);
             } // channel == 2
         }
+        void SQMidi::SQMidiControlDelegate::receivedControlChange14(int channel, int cc, int value){
+            // only process if completely started
+            if (sq6->state != State_Started){
+                return;
+            }
+
+            LISA_LOG(LogLevelDebug,"SQ CC14 ch(%d) cc(%d) value(%d)", channel, cc, value);
+
+            if (channel == 2){
+                faderChange(cc, (float)value / 16383.0);
+            }
+        }
+        void SQMidi::SQMidiControlDelegate::faderChange(int cc, float pos){
+            if (cc == 0){
+                sq6->lisaControllerProxy_.setMasterFaderPos(pos);
+            }
+            else if (cc == 1){
+                sq6->lisaControllerProxy_.setReverbFaderPos(pos);
+            }
+            else if (cc == 2){
+                sq6->lisaControllerProxy_.setMonitorFaderPos(pos);
+            }
+            else if (cc == 3){
+                sq6->lisaControllerProxy_.setUserFaderNPos(1, pos);
+            }
+            else if (cc == 4){
+                sq6->lisaControllerProxy_.setUserFaderNPos(2, pos);
+            }
+        }
         void SQMidi::SQMidiControlDelegate::receivedProgramChange(int channel, int program){
             // only process if completely started
             if (sq6->state != State_Started){
                 return;
             }
 
-            log(LogLevelDebug,"SQ PCH ch(%d) p(%d)", channel, program);
+            LISA_LOG(LogLevelDebug,"SQ PCH ch(%d) p(%d)", channel, program);
 
             if (channel == 1){
                 if (isValidSnapshotId(program)){
@@ -327,7 +343,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            sqMidiControlClient.sendControlChange(1,0,(int)(127.0 * pos));
+            sqMidiControlClient.sendFeedbackControlChange(1,0,(int)(127.0 * pos));
         }
 
         void SQMidi::receivedReverbFaderPos(float pos){
@@ -336,7 +352,7 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            sqMidiControlClient.sendControlChange(1,1,(int)(127.0 * pos));
+            sqMidiControlClient.sendFeedbackControlChange(1,1,(int)(127.0 * pos));
         }
 
     }
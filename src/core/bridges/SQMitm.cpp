@@ -18,6 +18,10 @@
 
 #include "bridges/SQMitm.h"
 
+#include <cstring>
+
+#include "Latency.h"
+#include "Metrics.h"
 #include "log.h"
 //#include "sqmixmitm/log.h"
 
@@ -31,6 +35,18 @@ namespace LisaDeskbridge {
                 Bridge(opts),
                 midiClient_(*this)
                 {
+            ignoreAll();
+            handle(MidiTypeNoteOn);
+            handle(MidiTypeNoteOff);
+            handle(MidiTypeControlChange);
+            handle(MidiTypePitchBend);
+
+            if (hiresFaders_){
+                for(int cc = 0; cc <= 4; cc++){
+                    assembleControlChange14(cc, 2);
+                }
+            }
+
             if (opts.contains("mixer-ip")){
                 mixerIp_ = opts["mixer-ip"];
                 //TODO validate
@@ -63,7 +79,7 @@ namespace LisaDeskbridge {
             mitm_.onConnectionStateChanged([&](SQMixMitm::MixMitm::ConnectionState state, SQMixMitm::Version &version){
                 if (state == SQMixMitm::MixMitm::Connected) {
 
-                    log(LogLevelInfo,"Connected to mixer (firmware %d.%d.%d r%d)\n",
+                    LISA_LOG(LogLevelInfo,"Connected to mixer (firmware %d.%d.%d r%d)\n",
                         version.major(), version.minor(), version.patch(), version.build());
                 } else {
 
@@ -72,58 +88,65 @@ namespace LisaDeskbridge {
 
             mitm_.onEvent(SQMixMitm::Event::Type::ChannelSelect, [&](SQMixMitm::Event &event){
 
-                log(LogLevelDebug, "event ChannelSelect physical %d virtual %d state %d", event.ChannelSelect_physical_strip(), event.ChannelSelect_channel(), event.ChannelSelect_onoff());
+                IngressScope ingress(ingressTagNow(LatencySourceMixer));
+                metrics.mixerEvents[MixerEventChannelSelect].increment();
 
-                if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
-                    return;
-                }
+                LISA_LOG(LogLevelDebug, "event ChannelSelect physical %d virtual %d state %d", event.ChannelSelect_physical_strip(), event.ChannelSelect_channel(), event.ChannelSelect_onoff());
 
-                // only channel select events with an ON state have an actually meaningful channel/source
-                if (!event.ChannelSelect_onoff()){
+                if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
                     return;
                 }
 
-                onSelectedChannel(event.ChannelSelect_channel());
+                postMixerEvent(MixerEventChannelSelect, event.ChannelSelect_channel(), event.ChannelSelect_onoff());
             });
 
             mitm_.onEvent(SQMixMitm::Event::Type::MidiSoftRotary, [&](SQMixMitm::Event &event){
 
-                log(LogLevelDebug, "event MidiSoftRotary", event.ChannelSelect_channel());
+                IngressScope ingress(ingressTagNow(LatencySourceMixer));
+                metrics.mixerEvents[MixerEventSoftRotary].increment();
+
+                LISA_LOG(LogLevelDebug, "event MidiSoftRotary", event.ChannelSelect_channel());
 
                 if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
                     return;
                 }
 
-                onMidiEvent(event.MidiSoftKey_channel(), event.MidiSoftRotary_type(),
+                postMixerEvent(MixerEventSoftRotary, event.MidiSoftKey_channel(), event.MidiSoftRotary_type(),
                             event.MidiSoftRotary_value1(), event.MidiSoftRotary_value2());
             });
 
             mitm_.onEvent(SQMixMitm::Event::Type::MidiSoftKey, [&](SQMixMitm::Event &event){
 
-                log(LogLevelDebug, "event MidiSoftKey", event.ChannelSelect_channel());
+                IngressScope ingress(ingressTagNow(LatencySourceMixer));
+                metrics.mixerEvents[MixerEventSoftKey].increment();
+
+                LISA_LOG(LogLevelDebug, "event MidiSoftKey", event.ChannelSelect_channel());
 
                 if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
                     return;
                 }
 
-                onMidiEvent(event.MidiSoftKey_channel(), event.MidiSoftKey_type(), event.MidiSoftKey_value1(),
+                postMixerEvent(MixerEventSoftKey, event.MidiSoftKey_channel(), event.MidiSoftKey_type(), event.MidiSoftKey_value1(),
                             event.MidiSoftKey_value2());
             });
 
             mitm_.onEvent(SQMixMitm::Event::Type::MidiFaderLevel, [&](SQMixMitm::Event &event){
 
-                log(LogLevelDebug, "event MidiFaderLevel ch %d %d", event.MidiFaderLevel_channel(), event.MidiFaderLevel_value());
+                IngressScope ingress(ingressTagNow(LatencySourceMixer));
+                metrics.mixerEvents[MixerEventFaderLevel].increment();
+
+                LISA_LOG(LogLevelDebug, "event MidiFaderLevel ch %d %d", event.MidiFaderLevel_channel(), event.MidiFaderLevel_value());
 
                 if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
                     return;
                 }
 
-                onMidiFaderLevel(event.MidiFaderLevel_channel(), event.MidiFaderLevel_value());
+                postMixerEvent(MixerEventFaderLevel, event.MidiFaderLevel_channel(), event.MidiFaderLevel_value());
             });
 
 //                mitm_.onEvent(SQMixMitm::Event::Types::MidiFaderMute, [&](SQMixMitm::Event &event){
 //
-//                    log(LogLevelDebug, "event MidiFaderMute ch %d %d %d %d", event.MidiFaderMute_channel(), event.databyte1(), event.databyte2(), event.databyte3());
+//                    LISA_LOG(LogLevelDebug, "event MidiFaderMute ch %d %d %d %d", event.MidiFaderMute_channel(), event.databyte1(), event.databyte2(), event.databyte3());
 //
 //                    if (mitm_.connectionState() != SQMixMitm::MixMitm::Connected || mitm_.state() != SQMixMitm::MixMitm::Running){
 //                        return;
@@ -137,15 +160,16 @@ namespace LisaDeskbridge {
         bool SQMitm::startMidiClient() {
             if (midiPortName_.length() == 0){
 //                error("No midi in- or out-port defined!");
-                log(LogLevelInfo, "Not using MIDI Client." );
+                LISA_LOG(LogLevelInfo, "Not using MIDI Client." );
                 return true;
             }
 
-            log(LogLevelInfo, "Starting MIDI Client.." );
+            LISA_LOG(LogLevelInfo, "Starting MIDI Client.." );
             try {
                 midiClient_.start(midiPortName_, midiPortName_);
+                midiClient_.startOutput(midiOutRate_, reactor());
             } catch (const std::exception & e){
-                log(LogLevelError, "starting MIDI Client: %s", e.what() );
+                LISA_LOG(LogLevelError, "starting MIDI Client: %s", e.what() );
                 return false;
             }
 
@@ -157,7 +181,8 @@ namespace LisaDeskbridge {
                 return;
             }
 
-            log(LogLevelInfo, "Stopping MIDI Client.." );
+            LISA_LOG(LogLevelInfo, "Stopping MIDI Client.." );
+            midiClient_.stopOutput();
             midiClient_.stop();
         }
 
@@ -170,7 +195,7 @@ namespace LisaDeskbridge {
 
             initMitm();
 
-            log(LogLevelInfo, "Starting SQ MITM Service for mixer at %s", mixerIp_.data());
+            LISA_LOG(LogLevelInfo, "Starting SQ MITM Service for mixer at %s", mixerIp_.data());
 
             if (mitm_.start((char*)mixerIp_.data())){
                 stopMidiClient();
@@ -180,7 +205,7 @@ namespace LisaDeskbridge {
             // set MITM service name as it will appear for app
             discoveryResponder_.name((char*)mitmName_.data());
 
-            log(LogLevelInfo, "Starting SQ Discovery Responder using name %s", mitmName_.data());
+            LISA_LOG(LogLevelInfo, "Starting SQ Discovery Responder using name %s", mitmName_.data());
             if (discoveryResponder_.start()){
                 mitm_.stop();
                 return false;
@@ -196,16 +221,63 @@ namespace LisaDeskbridge {
 
     void SQMitm::stopImpl() {
 
-        log(LogLevelInfo, "Stopping SQ Discovery Responder..");
+        LISA_LOG(LogLevelInfo, "Stopping SQ Discovery Responder..");
         discoveryResponder_.stop();
 
-        log(LogLevelInfo, "Stopping SQ MITM Service..");
+        LISA_LOG(LogLevelInfo, "Stopping SQ MITM Service..");
         mitm_.stop();
 
         stopMidiClient();
 
     }
 
+        void SQMitm::postMixerEvent(MixerEvent_t type, int arg0, int arg1, int arg2, int arg3){
+            Reactor * loop = reactor();
+            if (loop == nullptr){
+                onMixerEvent(type, arg0, arg1, arg2, arg3);
+                return;
+            }
+
+            int32_t data[1 + kCaptureMixerEventArgs] = {type, arg0, arg1, arg2, arg3};
+
+            bool posted = loop->post([](void * context, const Reactor::Task & task){
+                int32_t data[1 + kCaptureMixerEventArgs];
+                std::memcpy(data, task.data, sizeof(data));
+                ((SQMitm*)context)->onMixerEvent((MixerEvent_t)data[0], data[1], data[2], data[3], data[4]);
+            }, this, data, sizeof(data));
+
+            if (!posted){
+                LISA_LOG(LogLevelDebug, "Event loop queue full, dropped mixer event");
+            }
+        }
+
+        void SQMitm::onMixerEvent(MixerEvent_t type, int arg0, int arg1, int arg2, int arg3){
+
+            int32_t args[kCaptureMixerEventArgs] = {arg0, arg1, arg2, arg3};
+
+            capture(CaptureMixerEvent, (uint8_t)type, args, sizeof(args));
+
+            LisaControllerProxy::TxBatchScope batch;
+
+            switch(type){
+                case MixerEventChannelSelect:
+                    // only channel select events with an ON state have an actually meaningful channel/source
+                    if (args[1]){
+                        onSelectedChannel(args[0]);
+                    }
+                    break;
+                case MixerEventSoftRotary:
+                case MixerEventSoftKey:
+                    onMidiEvent(args[0], args[1], args[2], args[3]);
+                    break;
+                case MixerEventFaderLevel:
+                    onMidiFaderLevel(args[0], args[1]);
+                    break;
+                default:
+                    break;
+            }
+        }
+
         void SQMitm::onSelectedChannel(int channel){
 
 //            | Console Channel | ID (as per event) |
@@ -297,7 +369,7 @@ namespace LisaDeskbridge {
 
         void SQMitm::onMidiNoteOn(int channel, int note, int velocity){
 
-            log(LogLevelDebug, "midi Note On ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "midi Note On ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             if (channel == 1){
 //                if (!isValidDeviceId(note)){
@@ -359,7 +431,7 @@ namespace LisaDeskbridge {
 
         void SQMitm::onMidiNoteOff(int channel, int note, int velocity){
 
-            log(LogLevelDebug, "midi Note Off ch(%d) note(%d) velocity(%d)", channel, note, velocity);
+            LISA_LOG(LogLevelDebug, "midi Note Off ch(%d) note(%d) velocity(%d)", channel, note, velocity);
 
             if (channel == 1 && note == 1){
                 softBtn1_ = Released;
@@ -380,41 +452,40 @@ namespace LisaDeskbridge {
 
         void SQMitm::onMidiControlChange(int channel, int cc, int value){
 
-            log(LogLevelDebug,"midi CC ch(%d) cc(%d) value(%d)", channel, cc, value);
+            LISA_LOG(LogLevelDebug,"midi CC ch(%d) cc(%d) value(%d)", channel, cc, value);
 
             if (channel == 1){
                 if (1 <= cc && cc <= 8){
                     // turn a signed 7-bit value into a proper int value we can work with
                     int i = (int)(signed char)(value | ((value & 0b01000000) << 1));
-                    float r = (float)i * kDefaultRelativeStepSize;
                     if (cc == 1){
                         if (softBtn4_ == Released) {
-                            lisaControllerProxy_.setSelectedSourcesRelativePan(r);
+                            lisaControllerProxy_.setSelectedSourcesRelativePan(relativeStep(RelativePan, i));
                         } else {
-                            lisaControllerProxy_.setSelectedSourcesRelativeElevation(r);
+                            lisaControllerProxy_.setSelectedSourcesRelativeElevation(relativeStep(RelativeElevation, i));
                         }
                     } else if (cc == 2){
                         if (softBtn4_ == Released) {
-                            lisaControllerProxy_.setSelectedSourcesRelativePanSpread(r);
+                            lisaControllerProxy_.setSelectedSourcesRelativePanSpread(relativeStep(RelativePanSpread, i));
                         } else {
                             // do nothing
                         }
                     } else if (cc == 3){
                         if (softBtn4_ == Released) {
-                            lisaControllerProxy_.setSelectedSourcesRelativeWidth(r);
+                            lisaControllerProxy_.setSelectedSourcesRelativeWidth(relativeStep(RelativeWidth, i));
                         } else {
                             // do nothing
                         }
                     } else if (cc == 4){
                         if (softBtn4_ == Released) {
-                            lisaControllerProxy_.setSelectedSourcesRelativeDistance(r);
+                            lisaControllerProxy_.setSelectedSourcesRelativeDistance(relativeStep(RelativeDistance, i));
                         } else {
-                            lisaControllerProxy_.setSelectedSourceRelativeAuxSend(r);
+                            lisaControllerProxy_.setSelectedSourceRelativeAuxSend(relativeStep(RelativeAuxSend, i));
                         }
                     } else if (cc == 5){
-                        lisaControllerProxy_.setSelectedSourcesRelativeElevation(r);
+                        lisaControllerProxy_.setSelectedSourcesRelativeElevation(relativeStep(RelativeElevation, i));
                     } else if (cc == 6){
-                        lisaControllerProxy_.setSelectedSourceRelativeAuxSend(r);
+                        lisaControllerProxy_.setSelectedSourceRelativeAuxSend(relativeStep(RelativeAuxSend, i));
                     } else if (cc == 7){
                         // not used
                     } else if (cc == 8){
@@ -424,48 +495,44 @@ namespace LisaDeskbridge {
                 }
             } // channel == 1
             else if (channel == 2){
-                if (cc == 0){
-                    lisaControllerProxy_.setMasterFaderPos((float)value / 127.0);
-                }
-                else if (cc == 1){
-                    lisaControllerProxy_.setReverbFaderPos((float)value / 127.0);
-                }
-                else if (cc == 2){
-                    lisaControllerProxy_.setMonitorFaderPos((float)value / 127.0);
-                }
-                else if (cc == 3){
-                    lisaControllerProxy_.setUserFaderNPos(1, (float)value / 127.0);
-                }
-                else if (cc == 4){
-                    lisaControllerProxy_.setUserFaderNPos(2, (float)value / 127.0);
-                }
+                faderChange(cc, (float)value / 127.0);
             } // channel == 2
         }
 
+        void SQMitm::onMidiControlChange14(int channel, int cc, int value){
+
+            LISA_LOG(LogLevelDebug,"midi CC14 ch(%d) cc(%d) value(%d)", channel, cc, value);
+
+            if (channel == 2){
+                faderChange(cc, (float)value / 16383.0);
+            }
+        }
+
         void SQMitm::onMidiProgramChange(int channel, int program){
 
-            log(LogLevelDebug,"midi PC ch(%d) program(%d)", channel, program);
+            LISA_LOG(LogLevelDebug,"midi PC ch(%d) program(%d)", channel, program);
 
         }
 
         void SQMitm::onMidiFaderLevel(int channel, int value){
+            faderChange(channel, (float)value / 255.0);
+        }
 
-            channel += 1;
-
-            if (channel == 1){
-                lisaControllerProxy_.setMasterFaderPos((float)value / 255.0);
+        void SQMitm::faderChange(int fader, float pos){
+            if (fader == 0){
+                lisaControllerProxy_.setMasterFaderPos(pos);
             }
-            else if (channel == 2){
-                lisaControllerProxy_.setReverbFaderPos((float)value / 255.0);
+            else if (fader == 1){
+                lisaControllerProxy_.setReverbFaderPos(pos);
             }
-            else if (channel == 3){
-                lisaControllerProxy_.setMonitorFaderPos((float)value / 255.0);
+            else if (fader == 2){
+                lisaControllerProxy_.setMonitorFaderPos(pos);
             }
-            else if (channel == 4){
-                lisaControllerProxy_.setUserFaderNPos(1, (float)value / 255.0);
+            else if (fader == 3){
+                lisaControllerProxy_.setUserFaderNPos(1, pos);
             }
-            else if (channel == 5){
-                lisaControllerProxy_.setUserFaderNPos(2, (float)value / 255.0);
+            else if (fader == 4){
+                lisaControllerProxy_.setUserFaderNPos(2, pos);
             }
         }
 
@@ -475,7 +542,7 @@ namespace LisaDeskbridge {
 
         void SQMitm::receivedPitchBend(int channel, int bend){
 
-            log(LogLevelDebug,"midi pitchbend ch(%d) bend(%d)", channel, bend);
+            LISA_LOG(LogLevelDebug,"midi pitchbend ch(%d) bend(%d)", channel, bend);
         }
 
         void SQMitm::receivedMasterFaderPos(float pos){
@@ -486,7 +553,7 @@ namespace LisaDeskbridge {
 
 //            SQMixMitm::Command cmd = SQMixMitm::Command::midiFaderLevel()
             //TODO
-            midiClient_.sendControlChange(2,0,(int)(127.0 * pos));
+            midiClient_.sendFeedbackControlChange(2,0,(int)(127.0 * pos));
         }
 
         void SQMitm::receivedReverbFaderPos(float pos){
@@ -496,7 +563,7 @@ namespace LisaDeskbridge {
             }
 
             //TODO
-            midiClient_.sendControlChange(2,1,(int)(127.0 * pos));
+            midiClient_.sendFeedbackControlChange(2,1,(int)(127.0 * pos));
         }
 
 
@@ -17,11 +17,22 @@
 */
 
 #include "log.h"
+#include "MpscQueue.h"
 
 #include <stdarg.h>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
 #include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <pthread.h>
 
 namespace LisaDeskbridge {
 
@@ -29,14 +40,24 @@ namespace LisaDeskbridge {
 
     static FILE * logFile = stdout;
 
+    // where messages are written to, log() points here unless in async mode
+    static LogFunction logSink = defaultLog;
+
     LogFunction log = defaultLog;
 
+    std::atomic<int> logGate{LogLevelError};
+
+    static void updateLogGate(){
+        logGate.store(logSink == defaultLog ? (int)logLevel : (int)LogLevelDebug, std::memory_order_relaxed);
+    }
+
     LogLevel getLogLevel(){
         return logLevel;
     }
 
     void setLogLevel(LogLevel level){
         logLevel = level;
+        updateLogGate();
     }
 
     void setLogFile(FILE * file){
@@ -45,7 +66,11 @@ namespace LisaDeskbridge {
 
     void setLogFunction(LogFunction function){
         assert(function != nullptr);
-        log = function;
+        logSink = function;
+        if (!isAsyncLog()){
+            log = function;
+        }
+        updateLogGate();
     }
 
     void defaultLog(LogLevel level, const char * msg, ...){
@@ -95,4 +120,421 @@ namespace LisaDeskbridge {
         log(LogLevelError,"%s: %s", buffer, strerror(errno));
     }
 
+
+    // Async
+
+    static constexpr size_t kAsyncLogCapacity       = 512;
+    static constexpr size_t kAsyncLogMaxArgs        = 8;
+    static constexpr size_t kAsyncLogTextSize       = 256;
+    static constexpr size_t kAsyncLogLineSize       = 1024;
+
+    static constexpr std::chrono::milliseconds kAsyncLogPollInterval(20);
+
+    enum ArgKind_t {
+        ArgNone,        // %%
+        ArgInt,
+        ArgLong,
+        ArgLongLong,
+        ArgSize,
+        ArgIntMax,
+        ArgPtrDiff,
+        ArgDouble,
+        ArgLongDouble,
+        ArgString,
+        ArgPointer
+    };
+
+    struct FormatSpec {
+        bool valid;
+        int stars;      // number of '*' width/precision (int) arguments preceding the value
+        ArgKind_t kind;
+    };
+
+    union AsyncLogValue {
+        long long i;
+        long double f;
+        const void * p;
+        size_t str;     // offset into AsyncLogRecord::text
+    };
+
+    struct AsyncLogRecord {
+        LogLevel level;
+        const char * format;        // nullptr if text holds the already formatted message
+        unsigned int argCount;
+        AsyncLogValue args[kAsyncLogMaxArgs];
+        size_t textLength;
+        char text[kAsyncLogTextSize];  // (copied) string arguments
+    };
+
+    static MpscQueue<AsyncLogRecord, kAsyncLogCapacity> * asyncLogQueue = nullptr;
+    static std::thread * asyncLogThread = nullptr;
+    static std::mutex asyncLogMutex;
+    static std::condition_variable asyncLogCv;
+    static std::atomic<bool> asyncLogStop{false};
+    static std::atomic<uint64_t> asyncLogDropped{0};
+
+    /**
+     * Parses the conversion specification following a '%' (printf syntax), returns the position behind it.
+     */
+    static const char * parseFormatSpec(const char * p, FormatSpec & spec){
+        enum { LenNone, LenL, LenLL, LenZ, LenJ, LenT, LenBigL } length = LenNone;
+
+        spec.valid = true;
+        spec.stars = 0;
+        spec.kind = ArgNone;
+
+        // flags
+        while(*p != '\0' && std::strchr("-+ #0", *p) != nullptr){
+            p++;
+        }
+
+        // width
+        if (*p == '*'){
+            spec.stars++;
+            p++;
+        } else {
+            while('0' <= *p && *p <= '9'){
+                p++;
+            }
+        }
+
+        // precision
+        if (*p == '.'){
+            p++;
+            if (*p == '*'){
+                spec.stars++;
+                p++;
+            } else {
+                while('0' <= *p && *p <= '9'){
+                    p++;
+                }
+            }
+        }
+
+        // length modifier (h, hh are promoted to int anyways)
+        switch(*p){
+            case 'h':
+                p += (p[1] == 'h') ? 2 : 1;
+                break;
+            case 'l':
+                if (p[1] == 'l'){
+                    length = LenLL;
+                    p += 2;
+                } else {
+                    length = LenL;
+                    p++;
+                }
+                break;
+            case 'z': length = LenZ; p++; break;
+            case 'j': length = LenJ; p++; break;
+            case 't': length = LenT; p++; break;
+            case 'L': length = LenBigL; p++; break;
+            default:
+                break;
+        }
+
+        switch(*p){
+            case '%':
+                spec.valid = (spec.stars == 0);
+                break;
+
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+                switch(length){
+                    case LenL:  spec.kind = ArgLong;        break;
+                    case LenLL: spec.kind = ArgLongLong;    break;
+                    case LenZ:  spec.kind = ArgSize;        break;
+                    case LenJ:  spec.kind = ArgIntMax;      break;
+                    case LenT:  spec.kind = ArgPtrDiff;     break;
+                    default:    spec.kind = ArgInt;         break;
+                }
+                break;
+
+            case 'c':
+                spec.kind = ArgInt;
+                spec.valid = (length == LenNone);
+                break;
+
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec.kind = (length == LenBigL) ? ArgLongDouble : ArgDouble;
+                break;
+
+            case 's':
+                spec.kind = ArgString;
+                spec.valid = (length == LenNone);
+                break;
+
+            case 'p':
+                spec.kind = ArgPointer;
+                break;
+
+            default:
+                // %n, wide strings or just broken
+                spec.valid = false;
+                return p;
+        }
+
+        return p + 1;
+    }
+
+    /**
+     * Copies everything needed to format the message later on.
+     */
+    static void asyncLogCapture(AsyncLogRecord & record, LogLevel level, const char * format, va_list * args){
+
+        record.level = level;
+        record.format = format;
+        record.argCount = 0;
+        record.textLength = 0;
+
+        bool ok = true;
+
+        va_list ap;
+        va_copy(ap, *args);
+
+        for(const char * p = format; ok && *p != '\0';){
+            if (*p != '%'){
+                p++;
+                continue;
+            }
+
+            FormatSpec spec;
+            p = parseFormatSpec(p + 1, spec);
+
+            if (!spec.valid || kAsyncLogMaxArgs < record.argCount + spec.stars + 1){
+                ok = false;
+                break;
+            }
+
+            for(int i = 0; i < spec.stars; i++){
+                record.args[record.argCount++].i = va_arg(ap, int);
+            }
+
+            AsyncLogValue & value = record.args[record.argCount];
+
+            switch(spec.kind){
+                case ArgNone:
+                    continue;
+                case ArgInt:        value.i = va_arg(ap, int);          break;
+                case ArgLong:       value.i = va_arg(ap, long);         break;
+                case ArgLongLong:   value.i = va_arg(ap, long long);    break;
+                case ArgSize:       value.i = (long long)va_arg(ap, size_t);    break;
+                case ArgIntMax:     value.i = (long long)va_arg(ap, intmax_t);  break;
+                case ArgPtrDiff:    value.i = (long long)va_arg(ap, ptrdiff_t); break;
+                case ArgDouble:     value.f = va_arg(ap, double);       break;
+                case ArgLongDouble: value.f = va_arg(ap, long double);  break;
+                case ArgPointer:    value.p = va_arg(ap, void *);       break;
+                case ArgString: {
+                    const char * str = va_arg(ap, const char *);
+                    if (str == nullptr){
+                        str = "(null)";
+                    }
+                    size_t available = sizeof(record.text) - record.textLength;
+                    if (available == 0){
+                        ok = false;
+                        break;
+                    }
+                    // truncate if necessary
+                    size_t l = std::min(std::strlen(str), available - 1);
+                    std::memcpy(record.text + record.textLength, str, l);
+                    record.text[record.textLength + l] = '\0';
+                    value.str = record.textLength;
+                    record.textLength += l + 1;
+                    break;
+                }
+            }
+
+            record.argCount++;
+        }
+
+        va_end(ap);
+
+        if (!ok){
+            // unsupported format, so format it right here (slow, but rare)
+            va_copy(ap, *args);
+            vsnprintf(record.text, sizeof(record.text), format, ap);
+            va_end(ap);
+
+            record.format = nullptr;
+        }
+    }
+
+    template<typename T>
+    static int asyncLogFormatValue(char * buffer, size_t size, const char * spec, int stars, const int * star, T value){
+        switch(stars){
+            case 0:
+                return snprintf(buffer, size, spec, value);
+            case 1:
+                return snprintf(buffer, size, spec, star[0], value);
+            default:
+                return snprintf(buffer, size, spec, star[0], star[1], value);
+        }
+    }
+
+    static void asyncLogOutput(const AsyncLogRecord & record){
+
+        if (record.format == nullptr){
+            logSink(record.level, "%s", record.text);
+            return;
+        }
+
+        char line[kAsyncLogLineSize];
+        size_t len = 0;
+        unsigned int a = 0;
+
+        for(const char * p = record.format; *p != '\0' && len < sizeof(line) - 1;){
+            if (*p != '%'){
+                line[len++] = *p++;
+                continue;
+            }
+
+            const char * start = p;
+
+            FormatSpec spec;
+            p = parseFormatSpec(p + 1, spec);
+
+            if (spec.kind == ArgNone){
+                line[len++] = '%';
+                continue;
+            }
+
+            char specStr[32];
+            size_t specLen = std::min((size_t)(p - start), sizeof(specStr) - 1);
+            std::memcpy(specStr, start, specLen);
+            specStr[specLen] = '\0';
+
+            int star[2] = {0, 0};
+            for(int i = 0; i < spec.stars; i++){
+                star[i] = (int)record.args[a++].i;
+            }
+
+            const AsyncLogValue & value = record.args[a++];
+
+            char * dst = line + len;
+            size_t size = sizeof(line) - len;
+            int n = 0;
+
+            switch(spec.kind){
+                case ArgInt:        n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (int)value.i);           break;
+                case ArgLong:       n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (long)value.i);          break;
+                case ArgLongLong:   n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, value.i);                break;
+                case ArgSize:       n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (size_t)value.i);        break;
+                case ArgIntMax:     n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (intmax_t)value.i);      break;
+                case ArgPtrDiff:    n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (ptrdiff_t)value.i);     break;
+                case ArgDouble:     n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, (double)value.f);        break;
+                case ArgLongDouble: n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, value.f);                break;
+                case ArgString:     n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, record.text + value.str); break;
+                case ArgPointer:    n = asyncLogFormatValue(dst, size, specStr, spec.stars, star, value.p);                break;
+                default:
+                    break;
+            }
+
+            if (n > 0){
+                len = std::min(len + n, sizeof(line) - 1);
+            }
+        }
+
+        line[len] = '\0';
+
+        logSink(record.level, "%s", line);
+    }
+
+    static void asyncLog(LogLevel level, const char * format, ...){
+
+        // the default log function would discard it anyways
+        if (logSink == defaultLog && logLevel < level){
+            return;
+        }
+
+        va_list args;
+        va_start(args, format);
+
+        bool queued = asyncLogQueue->push([&](AsyncLogRecord & record){
+            asyncLogCapture(record, level, format, &args);
+        });
+
+        va_end(args);
+
+        if (!queued){
+            asyncLogDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void asyncLogRun(){
+        uint64_t reportedDrops = 0;
+
+        for(;;){
+            bool stop = asyncLogStop.load(std::memory_order_acquire);
+
+            while(asyncLogQueue->pop(asyncLogOutput)){
+                // until drained
+            }
+
+            uint64_t drops = asyncLogDropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops){
+                logSink(LogLevelError, "Dropped %llu log messages", (unsigned long long)(drops - reportedDrops));
+                reportedDrops = drops;
+            }
+
+            if (stop){
+                return;
+            }
+
+            // loggers never notify (as to never block), so just poll
+            std::unique_lock<std::mutex> lock(asyncLogMutex);
+            asyncLogCv.wait_for(lock, kAsyncLogPollInterval, [](){
+                return asyncLogStop.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    void startAsyncLog(){
+        if (isAsyncLog()){
+            return;
+        }
+
+        // NOTE never deleted, a thread might still be logging while async mode is stopped
+        if (asyncLogQueue == nullptr){
+            asyncLogQueue = new MpscQueue<AsyncLogRecord, kAsyncLogCapacity>();
+        }
+
+        asyncLogStop = false;
+
+        // signals are none of the worker's business (and might be sigwait()ed for elsewhere)
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &previous);
+
+        asyncLogThread = new std::thread(asyncLogRun);
+
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+        log = asyncLog;
+    }
+
+    void stopAsyncLog(){
+        if (!isAsyncLog()){
+            return;
+        }
+
+        log = logSink;
+
+        {
+            std::lock_guard<std::mutex> lock(asyncLogMutex);
+            asyncLogStop = true;
+        }
+        asyncLogCv.notify_one();
+
+        asyncLogThread->join();
+        delete asyncLogThread;
+        asyncLogThread = nullptr;
+    }
+
+    bool isAsyncLog(){
+        return asyncLogThread != nullptr;
+    }
+
+    uint64_t getDroppedLogCount(){
+        return asyncLogDropped.load(std::memory_order_relaxed);
+    }
+
 }
@@ -19,10 +19,15 @@
 #ifndef LISA_DESKBRIDGE_BRIDGE_H
 #define LISA_DESKBRIDGE_BRIDGE_H
 
+#include "EncoderAcceleration.h"
 #include "LisaControllerProxy.h"
+#include "MidiSender.h"
+#include "PeriodicTask.h"
+#include "Reactor.h"
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace LisaDeskbridge {
 
@@ -46,19 +51,60 @@ namespace LisaDeskbridge {
 
             static constexpr char kOptClaimLevelControl[]   = "claim-level-control";
 
+            static constexpr char kOptRelativeFlushRate[]   = "relative-flush-rate";
+
+            // per parameter: <option>-<parameter> (see EncoderAcceleration::paramName())
+            static constexpr char kOptRelativeStep[]        = "relative-step";
+            static constexpr char kOptRelativeAccel[]       = "relative-accel";
+
+            static constexpr char kOptHiresFaders[]         = "hires-faders";
+            static constexpr char kOptMidiOutRate[]         = "midi-out-rate";
+
+            static constexpr char kOptValueCacheEpsilon[]   = "value-cache-epsilon";
+            static constexpr char kOptValueCacheMaxAge[]    = "value-cache-max-age";
+
+            static constexpr char kOptMetricsFile[]         = "metrics-file";
+            static constexpr char kOptMetricsInterval[]     = "metrics-interval";
+            static constexpr char kOptEventLoop[]           = "event-loop";
+
+            static constexpr char kOptPingInterval[]        = "ping-interval";
+            static constexpr char kOptPingTimeout[]         = "ping-timeout";
+
+            static constexpr unsigned int kPingIntervalDefault  = 1000; // ms
+            static constexpr unsigned int kPingTimeoutDefault   = 3000; // ms
+
+            // ping interval (ms) while L-ISA Controller is not responding (to re-register as soon as it is back)
+            static constexpr unsigned int kPingRetryInterval    = 100;
+
             static constexpr char helpOpts[] = "\n"
-                                               "\t lisa-controller-ip\n"
+                                               "\t lisa-controller-ip      ip[:port][,ip[:port]..]: everything is sent to all, feedback is taken from the first one alive (see ping-timeout)\n"
                                                "\t lisa-controller-port\n"
                                                "\t device-ip\n"
                                                "\t device-port\n"
                                                "\t device-id\n"
                                                "\t device-name\n"
-                                               "\t claim-level-control\n";
+                                               "\t claim-level-control\n"
+                                               "\t relative-flush-rate     Rate (Hz) at which relative changes are sent, 0 = send immediately (default 200)\n"
+                                               "\t relative-step           Change per encoder tick (default 0.0025), relative-step-<param> for a single parameter\n"
+                                               "\t relative-accel          Factor by which fast encoder turns are scaled up at most, 1 = off (default 8), relative-accel-<param> for a single parameter\n"
+                                               "\t                         (params: pan, width, distance, elevation, pan-spread, aux-send)\n"
+                                               "\t hires-faders            1 = fader CCs are 14 bit (MSB on the fader's CC, LSB on CC + 32) (default 0)\n"
+                                               "\t midi-out-rate           Rate (Hz) at which MIDI feedback is sent (latest value per controller), 0 = send immediately (default 100)\n"
+                                               "\t value-cache-epsilon     Absolute values changed by at most this are not sent again, -1 = send all (default 0)\n"
+                                               "\t value-cache-max-age     Age (ms) of the last send after which an unchanged value is sent anyway, 0 = never (default 1000)\n"
+                                               "\t metrics-file            Periodically write counters to this file (Prometheus text format)\n"
+                                               "\t metrics-interval        Interval (ms) at which to write metrics-file (default 1000)\n"
+                                               "\t event-loop              'threads' (default) or 'epoll' (Linux only): receive and send OSC, handle MIDI, mixer events and timers on a single thread (MIDI and mixer input only arrive on their library's threads)\n"
+                                               "\t ping-interval           Interval (ms) at which to ping L-ISA Controller, 0 = never (default 1000)\n"
+                                               "\t ping-timeout            L-ISA Controller not replying for this long (ms, more than ping-interval) is considered gone, the device is registered again once it replies (default 3000)\n";
 
         protected: // Core
 
             enum State state = State_Stopped;
 
+            // started by startDetached()
+            bool detached_ = false;
+
             LisaControllerProxy lisaControllerProxy_;
 
         protected: // Settings
@@ -66,6 +112,9 @@ namespace LisaDeskbridge {
             std::string lisaControllerIp_                       = LisaDeskbridge::kLisaControllerIpDefault;
             uint16_t lisaControllerPort_                        = LisaDeskbridge::kLisaControllerPortDefault;
 
+            // if more than one (main and backups), port 0 = lisaControllerPort_
+            std::vector<LisaControllerProxy::ControllerAddress> lisaControllers_;
+
             std::string deviceIp_                               = "127.0.0.1";
             uint16_t devicePort_                                = LisaDeskbridge::kDevicePortDefault;
             uint8_t deviceId_                                   = 1;
@@ -74,6 +123,74 @@ namespace LisaDeskbridge {
 //            bool register_                                      = false;
             bool claimLevelControl_                             = true;
 
+            unsigned int relativeFlushRate_                     = LisaControllerProxy::kRelativeFlushRateDefault;
+
+            // set by the constructor already, such that bridges can set up their MIDI delegates accordingly
+            bool hiresFaders_                                   = false;
+
+            unsigned int midiOutRate_                           = MidiSender_Single_Impl::kOutputRateDefault;
+
+            EncoderAcceleration encoderAcceleration_;
+
+            /**
+             * @param ticks signed encoder value
+             * @param time arrival time of the ticks, 0 = that of the input being handled (see Latency.h)
+             * @return (accelerated) relative change of param for ticks
+             */
+            float relativeStep(RelativeParam_t param, int ticks, uint64_t time = 0);
+
+            float valueCacheEpsilon_                            = LastValueCache::kEpsilonDefault;
+            unsigned int valueCacheMaxAge_                      = LastValueCache::kMaxAgeDefault;
+
+            std::string metricsFile_;
+            unsigned int metricsInterval_                       = 1000;
+
+            PeriodicTask metricsTask_;
+            int metricsTimer_                                   = -1; // on reactor
+            bool metricsFailed_                                 = false;
+
+            void writeMetrics();
+
+            bool useReactor_                                    = false;
+            Reactor reactor_;
+
+            /**
+             * @return the reactor, if the bridge runs on one (see kOptEventLoop): input from other threads must then
+             * be posted to it.
+             */
+            Reactor * reactor(){ return reactor_.isOpen() ? &reactor_ : nullptr; }
+
+            unsigned int pingInterval_                          = kPingIntervalDefault;
+            unsigned int pingTimeout_                           = kPingTimeoutDefault;
+
+            PeriodicTask livenessTask_;
+            int livenessTimer_                                  = -1; // on reactor
+
+            // as requested by the bridge, replayed when registering again
+            std::atomic<bool> sendingToSelf_{false};
+            std::atomic<bool> receivingFromSelf_{false};
+            std::atomic<bool> levelControlClaimed_{false};
+
+            std::atomic<bool> controllerAlive_[LisaControllerProxy::kMaxControllers];
+            std::atomic<uint64_t> reregistrations_{0};
+            std::atomic<uint64_t> failovers_{0};
+            uint64_t livenessSince_                             = 0;
+            uint64_t lastPing_                                  = 0;
+
+            void startLiveness();
+            void stopLiveness();
+            void checkLiveness();
+
+            /**
+             * Makes the first controller alive (other than the active one) the active one, if any.
+             */
+            void failover();
+
+            /**
+             * Registers the device (again) with its current name, send/receive and level control settings.
+             */
+            void registerWithLisaController();
+
 
         protected:
 
@@ -102,6 +219,16 @@ namespace LisaDeskbridge {
              */
             void stop();
 
+            /**
+             * Starts only the L-ISA Controller proxy (sending to the given transport, receiving nothing) without
+             * any implementation specific I/O, such that the bridge's handlers can be driven directly
+             * (benchmarks, simulations).
+             * Stop with stop().
+             */
+            bool startDetached(Transport & transport);
+
+            LisaControllerProxy & getLisaControllerProxy(){ return lisaControllerProxy_; }
+
             /**
              * Runloop: platform dependent code to do necessary event handling.
              * Not always needed... (on macos, if there is a main runloop anyways, not)
@@ -111,6 +238,24 @@ namespace LisaDeskbridge {
             void runloop();
             void stopRunloop();
 
+            /**
+             * Logs (info level) TX counters and MIDI/mixer to OSC latencies (p50/p99/max), optionally
+             * resetting the latter (for periodic reports).
+             * Also done on SIGUSR1 while in runloop().
+             */
+            void logStats(bool reset = false);
+
+            /**
+             * @return false if the (active) L-ISA Controller stopped replying to pings (see kOptPingTimeout)
+             */
+            bool isLisaControllerAlive(){
+                return controllerAlive_[lisaControllerProxy_.getActiveController()].load(std::memory_order_relaxed);
+            }
+
+        public: // LisaControllerProxy::Delegate
+
+            void receivedPong(unsigned int controller, uint64_t rtt);
+
 
         protected:
 
@@ -131,9 +276,13 @@ namespace LisaDeskbridge {
 
         private:
 
+            void configureLisaControllerProxy();
             bool startLisaControllerProxy();
             void stopLisaControllerProxy();
 
+            void runReactor();
+            void closeReactor();
+
     };
 
 }
@@ -0,0 +1,111 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LISA_DESKBRIDGE_CAPTURE_H
+#define LISA_DESKBRIDGE_CAPTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace LisaDeskbridge {
+
+    /**
+     * Capture file format (host byte order):
+     *
+     *  header: "LDBCAP" 0x00 <version>
+     *  records: <time:u64> <type:u8> <port:u8> <size:u16> <data:size bytes>
+     *
+     * time is monotonic (see latencyNow()) in ns: the arrival time of inputs (if known), the time sent of datagrams
+ * sent. Records are in order of capture, their times may thus be slightly out of order.
+     */
+    enum CaptureRecord_t {
+        CaptureMidiIn       = 1,    // port: MidiReceiver capture id, data: raw MIDI bytes
+        CaptureMixerEvent   = 2,    // port: MixerEvent_t, data: int32 x kCaptureMixerEventArgs
+        CaptureOscRx        = 3,    // data: packet received by LisaControllerProxy
+        CaptureOscTx        = 4     // data: datagram sent by LisaControllerProxy
+    };
+
+    constexpr char kCaptureMagic[] = "LDBCAP";
+    constexpr uint8_t kCaptureVersion = 1;
+    constexpr std::size_t kCaptureHeaderSize = 8;
+    constexpr std::size_t kCaptureRecordHeaderSize = 12;
+    constexpr std::size_t kCaptureMaxSize = UINT16_MAX;
+    constexpr unsigned int kCaptureMixerEventArgs = 4;
+
+    /**
+     * While capturing, MIDI input, SQ mixer events and the L-ISA Controller proxy's OSC traffic are written
+     * to the given file (see above). Records are queued (lock-free) and written by a thread of its own, records
+     * not fitting the queue are dropped (and reported once capture is stopped).
+     */
+    bool startCapture(const char * path);
+    void stopCapture();
+
+    extern std::atomic<bool> capturing;
+
+    inline bool isCapturing(){
+        return capturing.load(std::memory_order_acquire);
+    }
+
+    void captureRecord(CaptureRecord_t type, uint8_t port, const void * data, std::size_t size);
+
+    inline void capture(CaptureRecord_t type, uint8_t port, const void * data, std::size_t size){
+        if (isCapturing()){
+            captureRecord(type, port, data, size);
+        }
+    }
+
+    /**
+     * Sequential reading of a capture file.
+     */
+    class CaptureReader {
+
+        public:
+
+            struct Record {
+                uint64_t time;
+                CaptureRecord_t type;
+                uint8_t port;
+                uint16_t size;
+                char data[kCaptureMaxSize];
+            };
+
+        protected:
+
+            FILE * file = nullptr;
+
+        public:
+
+            ~CaptureReader(){
+                close();
+            }
+
+            bool open(const char * path);
+            void close();
+
+            /**
+             * @return false at the end of the file (or on a truncated record)
+             */
+            bool next(Record & record);
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_CAPTURE_H
@@ -0,0 +1,157 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_CONTROLLERSTATE_H
+#define LISA_DESKBRIDGE_CONTROLLERSTATE_H
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "LisaController.h"
+
+namespace LisaDeskbridge {
+
+    /**
+     * Shadow copy of the L-ISA Controller parameters reported back to us (see enableSendingToDevice()).
+     *
+     * Values not (yet) received are NaN, use isKnown() to check.
+     *
+     * There is a single writer (the proxy's receive thread), any thread may read: single values can be read
+     * at any time, getSnapshot() gives a consistent copy of everything (seqlock, retries while an update
+     * is in progress).
+     */
+    class ControllerState {
+
+        public:
+
+            static constexpr unsigned int kMaxSourceId = 96;
+
+            struct Snapshot {
+                uint64_t version;
+
+                float sourcePan[kMaxSourceId];
+                float sourceWidth[kMaxSourceId];
+                float sourceDepth[kMaxSourceId];
+                float sourceElevation[kMaxSourceId];
+                float sourceAuxSend[kMaxSourceId];
+
+                float masterGain;
+                float masterFaderPos;
+                float reverbGain;
+                float reverbFaderPos;
+            };
+
+            static bool isKnown(float value){ return !std::isnan(value); }
+
+        protected:
+
+            // even = stable, odd = update in progress
+            alignas(64) std::atomic<uint64_t> sequence{0};
+
+            // one cache-aligned array per parameter (structure of arrays)
+            alignas(64) std::atomic<float> sourcePan[kMaxSourceId];
+            alignas(64) std::atomic<float> sourceWidth[kMaxSourceId];
+            alignas(64) std::atomic<float> sourceDepth[kMaxSourceId];
+            alignas(64) std::atomic<float> sourceElevation[kMaxSourceId];
+            alignas(64) std::atomic<float> sourceAuxSend[kMaxSourceId];
+
+            alignas(64) std::atomic<float> masterGain;
+            std::atomic<float> masterFaderPos;
+            std::atomic<float> reverbGain;
+            std::atomic<float> reverbFaderPos;
+
+            void write(std::atomic<float> & field, float value);
+
+        public:
+
+            ControllerState();
+
+            /**
+             * Forgets all values.
+             */
+            void reset();
+
+            /**
+             * Number of updates so far (changes whenever any value changes).
+             */
+            uint64_t getVersion() const {
+                return sequence.load(std::memory_order_acquire) / 2;
+            }
+
+            Snapshot getSnapshot() const;
+
+            float getSourcePan(SourceId_t src) const {
+                assert(isValidSourceId(src));
+                return sourcePan[src - 1].load(std::memory_order_relaxed);
+            }
+            float getSourceWidth(SourceId_t src) const {
+                assert(isValidSourceId(src));
+                return sourceWidth[src - 1].load(std::memory_order_relaxed);
+            }
+            float getSourceDepth(SourceId_t src) const {
+                assert(isValidSourceId(src));
+                return sourceDepth[src - 1].load(std::memory_order_relaxed);
+            }
+            float getSourceElevation(SourceId_t src) const {
+                assert(isValidSourceId(src));
+                return sourceElevation[src - 1].load(std::memory_order_relaxed);
+            }
+            float getSourceAuxSend(SourceId_t src) const {
+                assert(isValidSourceId(src));
+                return sourceAuxSend[src - 1].load(std::memory_order_relaxed);
+            }
+
+            float getMasterGain() const { return masterGain.load(std::memory_order_relaxed); }
+            float getMasterFaderPos() const { return masterFaderPos.load(std::memory_order_relaxed); }
+            float getReverbGain() const { return reverbGain.load(std::memory_order_relaxed); }
+            float getReverbFaderPos() const { return reverbFaderPos.load(std::memory_order_relaxed); }
+
+            // Writer side (single thread only)
+
+            void setSourcePan(SourceId_t src, float pan){
+                assert(isValidSourceId(src));
+                write(sourcePan[src - 1], pan);
+            }
+            void setSourceWidth(SourceId_t src, float width){
+                assert(isValidSourceId(src));
+                write(sourceWidth[src - 1], width);
+            }
+            void setSourceDepth(SourceId_t src, float depth){
+                assert(isValidSourceId(src));
+                write(sourceDepth[src - 1], depth);
+            }
+            void setSourceElevation(SourceId_t src, float elevation){
+                assert(isValidSourceId(src));
+                write(sourceElevation[src - 1], elevation);
+            }
+            void setSourceAuxSend(SourceId_t src, float send){
+                assert(isValidSourceId(src));
+                write(sourceAuxSend[src - 1], send);
+            }
+
+            void setMasterGain(float gain){ write(masterGain, gain); }
+            void setMasterFaderPos(float pos){ write(masterFaderPos, pos); }
+            void setReverbGain(float gain){ write(reverbGain, gain); }
+            void setReverbFaderPos(float pos){ write(reverbFaderPos, pos); }
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_CONTROLLERSTATE_H
@@ -0,0 +1,89 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_ENCODERACCELERATION_H
+#define LISA_DESKBRIDGE_ENCODERACCELERATION_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "RelativeCoalescer.h"
+
+namespace LisaDeskbridge {
+
+    /**
+     * Turns encoder ticks into relative parameter changes, scaled up the faster the encoder is turned.
+     *
+     * The time between two ticks (in the same direction) of a parameter's encoder picks a factor on a curve:
+     * 1 at kSlowInterval and above, rising quadratically to the parameter's maximum factor at kFastInterval
+     * and below. Ie slow turns keep the plain step size, fast ones cover the range in a few messages.
+     */
+    class EncoderAcceleration {
+
+        public:
+
+            static constexpr float kDefaultStepSize = 0.0025;
+            static constexpr float kDefaultMaxFactor = 8.0;
+
+            static constexpr uint64_t kSlowInterval = 100000000; // ns
+            static constexpr uint64_t kFastInterval = 10000000; // ns
+
+            struct Curve {
+                float stepSize = kDefaultStepSize;
+                float maxFactor = kDefaultMaxFactor; // 1 = no acceleration
+            };
+
+            /**
+             * @return parameter name as used in options (eg. "pan-spread"), nullptr if invalid
+             */
+            static const char * paramName(RelativeParam_t param);
+
+        protected:
+
+            Curve curves[RelativeParamCount];
+
+            // time (see latencyNow()) and direction of the last tick, by parameter
+            std::atomic<uint64_t> lastTime[RelativeParamCount];
+            std::atomic<int> lastDirection[RelativeParamCount];
+
+        public:
+
+            EncoderAcceleration();
+
+            Curve & curve(RelativeParam_t param){
+                return curves[param];
+            }
+
+            /**
+             * @return factor by which a tick following the previous one after interval (ns) is scaled up
+             */
+            float factor(RelativeParam_t param, uint64_t interval) const;
+
+            /**
+             * Safe to call from any thread (concurrent turns of the same parameter merely accelerate each other).
+             *
+             * @param ticks signed encoder value (as decoded from a relative CC)
+             * @param time arrival time (see latencyNow()) of the ticks
+             * @return relative change to apply
+             */
+            float step(RelativeParam_t param, int ticks, uint64_t time);
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_ENCODERACCELERATION_H
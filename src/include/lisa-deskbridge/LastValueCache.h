@@ -0,0 +1,147 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_LASTVALUECACHE_H
+#define LISA_DESKBRIDGE_LASTVALUECACHE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "LisaController.h"
+
+namespace LisaDeskbridge {
+
+    enum FaderValue_t {
+        FaderValueMasterGain        = 0,
+        FaderValueMasterPos         = 1,
+        FaderValueReverbGain        = 2,
+        FaderValueReverbPos         = 3,
+        FaderValueMonitorGain       = 4,
+        FaderValueMonitorPos        = 5,
+        FaderValueUserFader1Gain    = 6,
+        FaderValueUserFader1Pos     = 7,
+        FaderValueUserFader2Gain    = 8,
+        FaderValueUserFader2Pos     = 9,
+
+        FaderValueCount             = 10
+    };
+
+    enum SourceValue_t {
+        SourceValuePan              = 0,
+        SourceValueWidth            = 1,
+        SourceValueDistance         = 2,
+        SourceValueElevation        = 3,
+        SourceValuePanSpread        = 4,
+        SourceValueAuxSend          = 5,
+
+        SourceValueCount            = 6
+    };
+
+    /**
+     * Remembers the last value sent to (or received from) the controller per absolute parameter, such that
+     * repeated values can be skipped.
+     *
+     * A value is considered redundant if it differs by at most epsilon from the last one, unless the last send
+     * is older than the max age (so a lost datagram is corrected by the next send of that parameter; nothing is
+     * resent on its own).
+     * Lock-free, concurrent updates of the same parameter at worst cause a redundant send.
+     */
+    class LastValueCache {
+
+        public:
+
+            static constexpr unsigned int kMaxSourceId = 96;
+
+            static constexpr float kEpsilonDefault = 0.0f;
+            static constexpr unsigned int kMaxAgeDefault = 1000; // ms
+
+            static std::size_t faderIndex(FaderValue_t param){
+                return param;
+            }
+            static std::size_t userFaderIndex(int fader, bool pos){
+                assert(1 <= fader && fader <= 2);
+                return FaderValueUserFader1Gain + 2 * (fader - 1) + (pos ? 1 : 0);
+            }
+            static std::size_t sourceIndex(SourceId_t src, SourceValue_t param){
+                assert(isValidSourceId(src));
+                return FaderValueCount + (src - 1) * SourceValueCount + param;
+            }
+
+        protected:
+
+            static constexpr std::size_t kSourceOffset = FaderValueCount;
+            static constexpr std::size_t kCount = FaderValueCount + kMaxSourceId * SourceValueCount;
+
+            std::atomic<float> values[kCount];
+            std::atomic<uint32_t> updatedAt[kCount]; // ms
+
+            std::atomic<bool> enabled{true};
+            std::atomic<float> epsilon{kEpsilonDefault};
+            std::atomic<uint32_t> maxAge{kMaxAgeDefault};
+
+            std::atomic<uint64_t> suppressed{0};
+
+            static uint32_t now();
+
+            void invalidateRange(std::size_t from, std::size_t to);
+
+        public:
+
+            LastValueCache();
+
+            bool isEnabled(){ return enabled; }
+            void setEnabled(bool enable);
+
+            float getEpsilon(){ return epsilon; }
+            void setEpsilon(float epsilon);
+
+            /**
+             * Age (ms) of the last send after which a value is sent again even if unchanged, 0 = never.
+             */
+            unsigned int getMaxAge(){ return maxAge; }
+            void setMaxAge(unsigned int ms);
+
+            /**
+             * Sends suppressed so far.
+             */
+            uint64_t getSuppressedCount(){ return suppressed.load(std::memory_order_relaxed); }
+
+            /**
+             * Tells whether value should be sent, if so it is remembered as the parameter's current value.
+             */
+            bool shouldSend(std::size_t index, float value);
+
+            /**
+             * Remembers the parameter's current value as reported by the controller.
+             */
+            void update(std::size_t index, float value);
+
+            /**
+             * Forgets the value(s), the next send will go through in any case.
+             */
+            void invalidate(std::size_t index);
+            void invalidateSources();
+            void invalidateSourceParam(SourceValue_t param);
+            void invalidateAll();
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_LASTVALUECACHE_H
@@ -0,0 +1,136 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_LATENCY_H
+#define LISA_DESKBRIDGE_LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace LisaDeskbridge {
+
+    enum LatencySource_t {
+        LatencySourceMidi   = 0,
+        LatencySourceMixer  = 1,
+
+        LatencySourceCount  = 2
+    };
+
+    const char * latencySourceName(LatencySource_t source);
+
+    // monotonic time in ns
+    inline uint64_t latencyNow(){
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    /**
+     * An ingress tag tells when (and from where) the input that caused whatever the current thread is doing
+     * came in, 0 = none. It is the timestamp with the source in its lowest bits (at the cost of 16ns resolution).
+     */
+    inline uint64_t makeIngressTag(LatencySource_t source, uint64_t time){
+        return (time & ~(uint64_t)0xF) | (uint64_t)(source + 1);
+    }
+    inline uint64_t ingressTagNow(LatencySource_t source){
+        return makeIngressTag(source, latencyNow());
+    }
+    inline LatencySource_t ingressSource(uint64_t tag){
+        return (LatencySource_t)((tag & 0xF) - 1);
+    }
+    inline uint64_t ingressTime(uint64_t tag){
+        return tag & ~(uint64_t)0xF;
+    }
+
+    // ingress tag of the input being handled by this thread
+    extern thread_local uint64_t currentIngress;
+
+    /**
+     * Sets the current thread's ingress tag for its lifetime.
+     */
+    class IngressScope {
+        protected:
+            uint64_t previous;
+        public:
+            explicit IngressScope(uint64_t tag) : previous(currentIngress) {
+                currentIngress = tag;
+            }
+            ~IngressScope(){
+                currentIngress = previous;
+            }
+            IngressScope(const IngressScope &) = delete;
+            IngressScope & operator=(const IngressScope &) = delete;
+    };
+
+    /**
+     * Lock-free log-linear histogram (in the spirit of HdrHistogram) of latencies in ns:
+     * values are bucketed by power of two, each subdivided in 16 linear sub-buckets, ie
+     * a relative error of at most 1/16.
+     */
+    class LatencyHistogram {
+
+        public:
+
+            static constexpr unsigned int kSubBucketBits = 4;
+            static constexpr unsigned int kSubBucketCount = 1 << kSubBucketBits;
+            static constexpr unsigned int kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+            struct Summary {
+                uint64_t count;
+                uint64_t p50;
+                uint64_t p99;
+                uint64_t max;
+            };
+
+        protected:
+
+            std::atomic<uint64_t> counts[kBucketCount];
+            std::atomic<uint64_t> total{0};
+            std::atomic<uint64_t> maxValue{0};
+
+            static unsigned int indexOf(uint64_t value);
+
+            // highest value falling into bucket
+            static uint64_t valueAt(unsigned int index);
+
+        public:
+
+            LatencyHistogram();
+
+            void record(uint64_t ns);
+
+            uint64_t count() const { return total.load(std::memory_order_relaxed); }
+            uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+
+            /**
+             * Value below (or at) which the given fraction (0.0 - 1.0) of recorded values lies.
+             */
+            uint64_t percentile(double fraction) const;
+
+            Summary summarize() const;
+
+            /**
+             * NOTE values recorded concurrently may be lost.
+             */
+            void reset();
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_LATENCY_H
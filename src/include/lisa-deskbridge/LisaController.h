@@ -80,6 +80,8 @@ namespace LisaDeskbridge {
     constexpr char kMsgRxSourceElevation[]              = "/ext/src/%u/e%n"; // 0.0 - 1.0
     constexpr char kMsgRxSourceAuxSend[]                = "/ext/src/%u/s%n"; // 0.0 - 1.0
 
+    constexpr char kMsgRxPong[]                         = "/ext/pong";      // reply to kMsgPing (to the given "ip" port)
+
     //// Messages from External Device to Controller
 
     // Source control flags
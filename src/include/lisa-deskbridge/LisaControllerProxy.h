@@ -19,13 +19,37 @@
 #ifndef LISA_DESKBRIDGE_LISACONTROLLERPROXY_H
 #define LISA_DESKBRIDGE_LISACONTROLLERPROXY_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "LisaController.h"
+#include "Capture.h"
+#include "ControllerState.h"
+#include "LastValueCache.h"
+#include "Latency.h"
+#include "Metrics.h"
+#include "MpscQueue.h"
+#include "OscAddresses.h"
+#include "PeriodicTask.h"
+#include "Reactor.h"
+#include "RelativeCoalescer.h"
+#include "Transport.h"
 
 #include "osc/OscPacketListener.h"
+#include "osc/OscOutboundPacketStream.h"
 #include "ip/UdpSocket.h"
 
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE 512
+#endif
+
 namespace LisaDeskbridge {
 
 
@@ -33,6 +57,9 @@ namespace LisaDeskbridge {
 
         public:
 
+            // Ethernet MTU - IPv4 and UDP headers, bundles are split to not exceed this
+            static constexpr std::size_t kOscMaxDatagramSize = 1472;
+
             class Delegate {
                 public:
                     virtual void receivedSourcePan(SourceId_t src, float pan){}
@@ -46,37 +73,451 @@ namespace LisaDeskbridge {
 
                     virtual void receivedReverbGain(float gain){}
                     virtual void receivedReverbFaderPos(float pos){}
+
+                    /**
+                     * Reply to ping() from the given controller (see getControllerCount()), rtt in ns (0 if there
+                     * was no ping outstanding).
+                     */
+                    virtual void receivedPong(unsigned int controller, uint64_t rtt){}
             };
 
+            struct ControllerAddress {
+                std::string address;
+                unsigned short port;
+            };
 
-        protected:
+            static constexpr std::size_t kMaxControllers = UdpFanoutTransport::kMaxTargets;
 
-            enum arg_t {INT_T, FLOAT_T, STRING_T};
+
+        protected:
 
             Delegate * iDelegate = nullptr;
+
+            const OscAddressTable & oscAddresses;
+
             UdpListeningReceiveSocket * udpListeningReceiveSocket = nullptr;
-            UdpTransmitSocket * udpTransmitSocket = nullptr;
+            Transport * transport = nullptr;
+            bool ownsTransport = false;
 
             bool mIsRunning = false;
 
             std::thread * thread = nullptr;
 
+            // if started on a reactor, receiving, sending and the relative flush timer are done by its thread instead
+            Reactor * reactor = nullptr;
+
+            // on Linux (or on a reactor), datagrams are received in batches (recvmmsg()) on a plain socket,
+            // elsewhere by oscpack's receive loop
+            static constexpr std::size_t kRxBatchSize = 32;
+            static constexpr std::size_t kRxDatagramSize = kOscMaxDatagramSize * 2;
+
+            int rxSocket = -1;
+            int rxStopFd = -1;
+            char rxBuffers[kRxBatchSize][kRxDatagramSize];
+
+            bool openRxSocket(unsigned short listenPort);
+            void closeRxSocket();
+            void rxRun();
+            void receiveAll();
+
+            // undoes a failed start()
+            void abortStart();
+
+            /**
+             * While processing a batch, only the latest value of each parameter is kept and handed to its
+             * handler (and the delegate) once the batch is done, in order of first arrival.
+             */
+            struct RxLatest {
+                float value;
+                bool pending;
+            };
+
+            bool rxCoalescing = false;
+            RxLatest rxLatest[RxAddressCount][OscAddressTable::kMaxSourceId + 1] = {};
+            RxAddress rxOrder[RxAddressCount * (OscAddressTable::kMaxSourceId + 1)];
+            std::size_t rxOrderCount = 0;
+
+            void beginRxBatch();
+            void endRxBatch();
+
+            /**
+             * Encoded messages/bundles are not sent by the calling thread but queued for the TX thread (or the
+             * reactor's thread, if started on one), which is the only one to use the transport.
+             */
+            struct Datagram {
+                uint64_t ingress; // see Latency.h
+                std::size_t size;
+                char data[kOscMaxDatagramSize];
+            };
+
+            static constexpr std::size_t kTxQueueCapacity = 256;
+
+            MpscQueue<Datagram, kTxQueueCapacity> txQueue;
+
+            std::thread * txThread = nullptr;
+            int txWakeFd = -1; // on reactor, instead of the TX thread
+            std::mutex txMutex;
+            std::condition_variable txCv;
+            std::atomic<bool> txSleeping{false};
+            bool txStopRequested = false;
+
+            std::atomic<uint64_t> txPushed{0};
+            std::atomic<uint64_t> txDropped{0};
+            std::atomic<uint64_t> txSent{0};
+            std::atomic<uint64_t> txSyscalls{0};
+
+            // the TX thread takes up to this many queued datagrams at once and hands them to the transport together
+            static constexpr std::size_t kTxBatchSize = UdpFanoutTransport::kMaxBatch;
+
+            Datagram txBatch[kTxBatchSize];
+
+            /**
+             * State of a thread's TxBatchScope(s): the proxy whose TX thread still is to be woken at its end.
+             */
+            struct TxDefer {
+                unsigned int depth = 0;
+                LisaControllerProxy * pending = nullptr;
+            };
+
+            static TxDefer & txDefer();
+            static void endTxBatch();
+
+            // from input (see IngressScope) to handing the datagram to the socket
+            LatencyHistogram latency[LatencySourceCount];
+
+            /**
+             * Everything is sent to all controllers, but only the active one's feedback is taken into account.
+             */
+            struct Controller {
+                std::string name;       // address:port
+                unsigned long address;  // as in IpEndpointName
+                int port;
+                // time (see latencyNow()) the outstanding ping was sent resp. the last pong was received, 0 = none
+                std::atomic<uint64_t> pingSentAt{0};
+                std::atomic<uint64_t> pongReceivedAt{0};
+            };
+
+            Controller controllers[kMaxControllers];
+            unsigned int controllerCount = 0;
+            std::atomic<unsigned int> activeController{0};
+
+            // of the active controller
+            LatencyHistogram pingRtt;
+
+            /**
+             * @return index of the controller the endpoint belongs to (by address, and port if that is ambiguous),
+             * -1 if none (always 0 if there is only one)
+             */
+            int controllerOf(const IpEndpointName & endpoint);
+
+            void startTx();
+            void stopTx();
+            void txRun();
+            void wakeTx();
+            void drainTx();
+            std::size_t popTxBatch();
+            void sendTxBatch(std::size_t count);
+
             SourceId_t lastSelectedSource = 0;
 
-            void sendToController(const char * address, int count, ...);
+            LastValueCache valueCache;
+
+            ControllerState state;
+
+            // state is reset by its single writer (the receiving thread), see forgetControllerState()
+            std::atomic<bool> stateResetRequested{false};
+
+            // handlers of received messages, indexed by RxAddress_t
+            typedef void (LisaControllerProxy::*RxHandler)(unsigned int id, float value);
+            static const RxHandler kRxHandlers[RxAddressCount];
+
+            void receivedMasterGain(unsigned int, float gain);
+            void receivedMasterFaderPos(unsigned int, float pos);
+            void receivedReverbGain(unsigned int, float gain);
+            void receivedReverbFaderPos(unsigned int, float pos);
+            void receivedPong(unsigned int controller);
+            void receivedSourcePan(unsigned int src, float pan);
+            void receivedSourceWidth(unsigned int src, float width);
+            void receivedSourceDistance(unsigned int src, float distance);
+            void receivedSourceElevation(unsigned int src, float elevation);
+            void receivedSourceAuxSend(unsigned int src, float send);
+
+            unsigned int relativeFlushRate = kRelativeFlushRateDefault;
+            std::atomic<bool> relativeCoalescing{false};
+            RelativeCoalescer relativeCoalescer;
+            PeriodicTask relativeFlushTask;
+            int relativeFlushTimer = -1; // on reactor
+
+            void startRelativeCoalescing();
+            void stopRelativeCoalescing();
+
+            /**
+             * Relative changes are summed up per target and parameter and sent at the configured flush rate
+             * (or sent right away if coalescing is disabled).
+             */
+            void sendRelative(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float value);
+            void sendRelativeNow(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float value);
+
+            /**
+             * Before absolute values are sent: pending relative changes would otherwise be applied on top of them
+             * (and keep the value cache from being invalidated until they are).
+             */
+            void flushPendingRelative(){
+                if (relativeCoalescer.hasPending()){
+                    flushRelative();
+                }
+            }
+
+            /**
+             * Argument types accepted by send(): int, float, bool and strings.
+             * NOTE: bools are sent as int 0/1 (as L-ISA Controller expects), not as OSC T/F.
+             */
+            template<typename T>
+            static constexpr bool isOscArg(){
+                typedef typename std::decay<T>::type U;
+                return std::is_same<U, int>::value || std::is_same<U, float>::value || std::is_same<U, bool>::value ||
+                       std::is_same<U, const char *>::value || std::is_same<U, char *>::value;
+            }
+
+            static void encodeArg(osc::OutboundPacketStream & stream, int value){ stream << (osc::int32)value; }
+            static void encodeArg(osc::OutboundPacketStream & stream, bool value){ stream << (osc::int32)(value ? 1 : 0); }
+            static void encodeArg(osc::OutboundPacketStream & stream, float value){ stream << value; }
+            static void encodeArg(osc::OutboundPacketStream & stream, const char * value){
+                assert(value != nullptr);
+                stream << value;
+            }
+
+            static std::size_t argSize(int value){ return 4; }
+            static std::size_t argSize(bool value){ return 4; }
+            static std::size_t argSize(float value){ return 4; }
+            static std::size_t argSize(const char * value){ return oscPaddedSize(std::strlen(value)); }
+
+            /**
+             * Encoded size of a message (address, type tags and arguments).
+             */
+            template<typename ... Args>
+            static std::size_t messageSize(const char * address, Args ... args){
+                return oscPaddedSize(std::strlen(address)) + oscPaddedSize(1 + sizeof...(Args)) + (0 + ... + argSize(args));
+            }
+
+            template<typename ... Args>
+            static void encodeMessage(osc::OutboundPacketStream & stream, const char * address, Args ... args){
+                stream << osc::BeginMessage( address );
+                (encodeArg(stream, args), ...);
+                stream << osc::EndMessage;
+            }
+
+            /**
+             * Messages sent by a thread while it has a bundle open (on this proxy) are collected here.
+             */
+            struct Bundle {
+                LisaControllerProxy * owner = nullptr;
+                unsigned int depth = 0;
+                unsigned int messageCount = 0;
+
+                // some headroom, such that a full bundle can still take its terminator
+                char buffer[kOscMaxDatagramSize + OUTPUT_BUFFER_SIZE];
+                osc::OutboundPacketStream stream;
+
+                Bundle() : stream(buffer, sizeof(buffer)){}
+            };
+
+            static osc::OutboundPacketStream & txStream();
+            static Bundle & txBundle();
+
+            void transmit(const char * data, std::size_t size);
+            void transmitBundle(Bundle & bundle);
+
+            /**
+             * Encodes and sends a single message to the controller (or adds it to the currently open bundle).
+             * OSC type tags are derived from the argument types, unsupported types fail to compile.
+             * @param cls as classifyAddress(address) would tell, known to every caller (and checked in debug builds)
+             */
+            template<typename ... Args>
+            void send(MessageClass_t cls, const char * address, Args ... args){
+                static_assert((isOscArg<Args>() && ...), "OSC arguments must be int, float, bool or string");
+                assert(address != nullptr);
+                assert(cls == classifyAddress(address));
+
+                metrics.oscTxMessages[cls].increment();
+
+                Bundle & bundle = txBundle();
+
+                if (bundle.owner == this){
+                    // each bundle element is prefixed with its size
+                    if (bundle.messageCount > 0 && kOscMaxDatagramSize < bundle.stream.Size() + 4 + messageSize(address, args...)){
+                        transmitBundle(bundle);
+                    }
+
+                    encodeMessage(bundle.stream, address, args...);
+                    bundle.messageCount++;
+                    return;
+                }
+
+                osc::OutboundPacketStream & stream = txStream();
+
+                stream.Clear();
+                encodeMessage(stream, address, args...);
+
+                transmit(stream.Data(), stream.Size());
+            }
 
         public:
 
-            LisaControllerProxy(Delegate * delegate){
+            static constexpr unsigned int kRelativeFlushRateDefault = 200; // Hz
+            static constexpr unsigned int kRelativeFlushRateMax = 1000; // Hz
+
+            LisaControllerProxy(Delegate * delegate) : oscAddresses(OscAddressTable::instance()){
                 iDelegate = delegate;
             }
 
             bool isRunning(){ return mIsRunning; }
-            void start(unsigned short listenPort, std::string &controllerAddress, unsigned short controllerPort);
+            /**
+             * If a reactor is given, the proxy's socket is handled by the reactor's thread (and received messages
+             * are processed on it), otherwise by a thread of its own.
+             */
+            void start(unsigned short listenPort, std::string &controllerAddress, unsigned short controllerPort, Reactor * reactor = nullptr);
+
+            /**
+             * Sends to all given controllers (at most kMaxControllers), the first one being the active one
+             * initially (see setActiveController()).
+             */
+            void start(unsigned short listenPort, const std::vector<ControllerAddress> & controllers, Reactor * reactor = nullptr);
+
+            /**
+             * Starts without any sockets: nothing is received and all datagrams are handed to the given
+             * transport (which must outlive the proxy's running time), eg. for benchmarks.
+             */
+            void startDetached(Transport & transport);
+
             void stop();
 
+            virtual void ProcessPacket( const char * data, int size, const IpEndpointName& remoteEndpoint );
             virtual void ProcessMessage( const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint );
 
+            struct TxStats {
+                std::size_t depth;  // currently queued datagrams
+                uint64_t pushed;    // datagrams queued
+                uint64_t dropped;   // datagrams dropped because the queue was full
+                uint64_t sent;      // datagrams sent
+                uint64_t syscalls;  // it took to send them (see TxBatchScope)
+            };
+
+            TxStats getTxStats();
+
+            LatencyHistogram & getLatency(LatencySource_t source){
+                assert(0 <= source && source < LatencySourceCount);
+                return latency[source];
+            }
+
+            /**
+             * Round trip times of ping() to the active controller (until the reply is received, in ns).
+             */
+            LatencyHistogram & getPingRtt(){ return pingRtt; }
+
+            unsigned int getControllerCount(){ return controllerCount; }
+
+            const std::string & getControllerName(unsigned int controller){
+                assert(controller < controllerCount);
+                return controllers[controller].name;
+            }
+
+            unsigned int getActiveController(){ return activeController.load(std::memory_order_acquire); }
+
+            /**
+             * Feedback from any other controller is ignored from now on.
+             */
+            void setActiveController(unsigned int controller){
+                assert(controller < controllerCount);
+                activeController.store(controller, std::memory_order_release);
+            }
+
+            /**
+             * @return time (see latencyNow()) the last reply to ping() was received from the given controller, 0 = never
+             */
+            uint64_t getLastPong(unsigned int controller){
+                assert(controller < controllerCount);
+                return controllers[controller].pongReceivedAt.load(std::memory_order_acquire);
+            }
+
+            /**
+             * Absolute fader and source parameter values equal (within epsilon) to the last one sent or received
+             * are not sent again, unless they are older than the max age.
+             */
+            LastValueCache & getValueCache(){ return valueCache; }
+
+            /**
+             * Parameter values as last reported by the controller (safe to read from any thread).
+             */
+            const ControllerState & getState(){ return state; }
+
+            /**
+             * Forgets what is known about the controller's values (eg. once it restarted or another controller took
+             * over): nothing is suppressed as redundant anymore and the state is reset before the next message
+             * received.
+             */
+            void forgetControllerState(){
+                valueCache.invalidateAll();
+                stateResetRequested.store(true, std::memory_order_release);
+            }
+
+            /**
+             * Rate at which coalesced relative changes are sent, 0 disables coalescing.
+             */
+            unsigned int getRelativeFlushRate(){ return relativeFlushRate; }
+            void setRelativeFlushRate(unsigned int hz);
+
+            /**
+             * Sends any pending relative changes right away.
+             * Is done implicitly before selection changes, snapshot recalls and absolute parameter changes, such that
+             * pending changes still apply to the sources (and values) they were meant for.
+             */
+            void flushRelative();
+
+            /**
+             * Datagrams queued by the calling thread for its lifetime (eg. while handling an input event) do not wake
+             * the TX thread one by one, but only once at the end of the (outermost) scope, such that they are sent
+             * together (with a single sendmmsg() call on Linux). Applies to any proxy.
+             */
+            class TxBatchScope {
+                public:
+                    TxBatchScope(){
+                        txDefer().depth++;
+                    }
+                    ~TxBatchScope(){
+                        endTxBatch();
+                    }
+                    TxBatchScope(const TxBatchScope &) = delete;
+                    TxBatchScope & operator=(const TxBatchScope &) = delete;
+            };
+
+            /**
+             * All messages sent by the calling thread between beginBundle() and endBundle() are sent as
+             * OSC bundle(s) (one datagram each) instead of a datagram per message.
+             * Bundles exceeding kOscMaxDatagramSize are split, bundles can be nested (only the outermost
+             * endBundle() sends).
+             */
+            void beginBundle();
+            void endBundle();
+
+            /**
+             * Keeps a bundle open for its lifetime (and the datagrams it may be split into together).
+             */
+            class BundleScope {
+                protected:
+                    TxBatchScope batch;
+                    LisaControllerProxy & proxy;
+                public:
+                    explicit BundleScope(LisaControllerProxy & proxy) : proxy(proxy){
+                        proxy.beginBundle();
+                    }
+                    ~BundleScope(){
+                        proxy.endBundle();
+                    }
+                    BundleScope(const BundleScope &) = delete;
+                    BundleScope & operator=(const BundleScope &) = delete;
+            };
+
         public:
 
 
@@ -239,6 +680,10 @@ namespace LisaDeskbridge {
 
             // ping
 
+            /**
+             * Asks all controllers to reply (kMsgRxPong) to the given address, see getPingRtt() and
+             * Delegate::receivedPong().
+             */
             void ping(const char ipAddress[], unsigned short port);
 
     };
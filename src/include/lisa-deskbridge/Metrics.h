@@ -0,0 +1,111 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_METRICS_H
+#define LISA_DESKBRIDGE_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "OscAddresses.h"
+
+namespace LisaDeskbridge {
+
+    class Counter {
+        protected:
+            std::atomic<uint64_t> value{0};
+        public:
+            void increment(){ value.fetch_add(1, std::memory_order_relaxed); }
+            void add(uint64_t n){ value.fetch_add(n, std::memory_order_relaxed); }
+            uint64_t get() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    // by status nibble (0x8 - 0xF)
+    enum MidiType_t {
+        MidiTypeNoteOff         = 0,
+        MidiTypeNoteOn          = 1,
+        MidiTypePolyPressure    = 2,
+        MidiTypeControlChange   = 3,
+        MidiTypeProgramChange   = 4,
+        MidiTypeAftertouch      = 5,
+        MidiTypePitchBend       = 6,
+        MidiTypeSystem          = 7,
+
+        MidiTypeCount           = 8
+    };
+
+    inline MidiType_t midiTypeOf(uint8_t status){
+        return (MidiType_t)((status >> 4) & 0x7);
+    }
+
+    // SQ mixer events handled by the SQ-Mitm bridge
+    enum MixerEvent_t {
+        MixerEventChannelSelect = 0,
+        MixerEventSoftRotary    = 1,
+        MixerEventSoftKey       = 2,
+        MixerEventFaderLevel    = 3,
+
+        MixerEventCount         = 4
+    };
+
+    /**
+     * Process wide counters, recording is a relaxed atomic increment (no locks, safe from any thread).
+     */
+    struct Metrics {
+        Counter oscTxMessages[MessageClassCount];
+        Counter oscRxMessages[MessageClassCount];
+        Counter oscRxParseErrors;
+        Counter oscRxIgnored; // from other than the active controller
+
+        // received datagrams resp. the batches (wakeups) they came in, and values superseded within a batch
+        Counter oscRxDatagrams;
+        Counter oscRxBatches;
+        Counter oscRxCoalesced;
+
+        Counter midiRxMessages[MidiTypeCount];
+        Counter midiRxIgnored; // not handled by the receiving delegate
+
+        // sent, replaced by a later value before being sent resp. dropped (output queue full)
+        Counter midiTxMessages;
+        Counter midiTxSuperseded;
+        Counter midiTxDropped;
+
+        Counter mixerEvents[MixerEventCount];
+
+        // relative changes handed to the proxy resp. messages actually sent for them (difference = coalesced)
+        Counter relativeChanges;
+        Counter relativeMessages;
+
+        /**
+         * Writes all counters in Prometheus' text exposition format.
+         */
+        void writePrometheus(FILE * file) const;
+    };
+
+    extern Metrics metrics;
+
+    /**
+     * Helpers to write a Prometheus metric (with an optional label).
+     */
+    void writePrometheusHeader(FILE * file, const char * name, const char * type, const char * help);
+    void writePrometheusValue(FILE * file, const char * name, uint64_t value, const char * label = nullptr, const char * labelValue = nullptr);
+
+}
+
+#endif //LISA_DESKBRIDGE_METRICS_H
@@ -19,22 +19,160 @@
 #ifndef LISA_DESKBRIDGE_MIDIRECEIVER_H
 #define LISA_DESKBRIDGE_MIDIRECEIVER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include <libremidi/libremidi.hpp>
 
+#include "Metrics.h"
+#include "Reactor.h"
+
 namespace LisaDeskbridge {
 
     class MidiReceiver {
 
         public:
 
+            /**
+             * Messages are dispatched on their status byte through a table of handlers, initially covering all
+             * channel voice messages on all channels. System messages (clock, active sensing, ..) are never handled.
+             *
+             * Delegates may narrow this down to the (type, channel) pairs they care about (using ignoreAll() and
+             * handle()); anything else is dropped by the receiver on the first byte. Set up the table before the
+             * receiver is started, it is not synchronized.
+             *
+             * Optionally, 14-bit control changes (MSB on CC 0-31 followed by the LSB on CC 32-63) and NRPN/RPN
+             * sequences are assembled into single high resolution events (see assembleControlChange14() and
+             * assembleParameterNumbers()). A pending MSB is given up on (and delivered as is, with an LSB of 0)
+             * once another control change follows on its channel, or by the receiver's timer kPairTimeout after it
+             * arrived at the latest (see MidiReceiver::startPairTimer()). Controllers never seen sending an LSB have
+             * their MSBs delivered right away.
+             */
             class Delegate {
 
-                friend class MidiReceiver_Single_Impl;
+                friend class MidiReceiver;
+
+            public:
+
+                // channel argument matching all 16 channels
+                static constexpr int kAllChannels = 0;
+
+                typedef void (*Handler)(Delegate & delegate, const unsigned char * bytes, std::size_t size);
+
+                static constexpr uint64_t kPairTimeout = 20000000; // ns
+
+            private:
+
+                struct HighResolutionState {
+                    // dispatch vs. expiry by the receiver's timer (on different threads unless using a reactor),
+                    // never held while delivering
+                    std::mutex mutex;
+
+                    // channels with a pending MSB (checked by the timer without locking)
+                    std::atomic<unsigned int> pendingCount{0};
+
+                    // timer thread (unless using a reactor), sleeping until an MSB is held back
+                    std::condition_variable timerWake;
+                    bool timerIdle = false;
+                    bool timerStop = false;
+                    bool pendingSet = false; // since the timer last looked
+
+                    bool parameterNumbers = false;
+
+                    struct Channel {
+                        uint32_t pairs = 0; // bit by MSB controller number (0-31)
+                        uint8_t msb[32] = {};
+                        uint32_t lsbSeen = 0;
+
+                        int pending = -1; // MSB controller waiting for its LSB
+                        uint64_t pendingSince = 0;
+
+                        // selected (N)RPN, 127/127 = none
+                        uint8_t parameterMsb = 127;
+                        uint8_t parameterLsb = 127;
+                        bool registered = false;
+                    } channels[16];
+                };
+
+                std::unique_ptr<HighResolutionState> highResolution;
+
+                static void dispatchHighResolution(Delegate & delegate, const unsigned char * bytes, std::size_t size);
+
+                // a high resolution event, resolved while locked and delivered after unlocking
+                struct Delivery {
+                    int channel;
+                    int number; // MSB controller resp. parameter number
+                    int value;
+                    bool parameter;
+                    bool registered;
+                };
+
+                void receivedHighResolution(int channel, int cc, int value);
+
+                // @return false if there is nothing to deliver (data entry without selected parameter)
+                bool resolveHighResolution(int channel, int cc, int value, Delivery & delivery);
+                void deliverHighResolution(const Delivery & delivery);
+
+                // sets (cc = -1 clears) the MSB waiting for its LSB
+                void setPending(HighResolutionState::Channel & ch, int cc, uint64_t since);
+
+                /**
+                 * Delivers pending MSBs that have been waiting for kPairTimeout as of now (see latencyNow()).
+                 */
+                void expireHighResolution(uint64_t now);
 
             protected:
-                void receivedMessage(const libremidi::message& message) ;
+
+                Handler handlers[256];
+
+                void handle(MidiType_t type, int channel = kAllChannels);
+                void ignore(MidiType_t type, int channel = kAllChannels);
+                void ignoreAll();
+
+                /**
+                 * Delivers given controller (0-31) and its LSB counterpart (+32) as receivedControlChange14().
+                 */
+                void assembleControlChange14(int cc, int channel = kAllChannels, bool enabled = true);
+
+                /**
+                 * Delivers NRPN/RPN (CC 99/98 resp. 101/100) data entries (CC 6/38) as receivedParameterChange(),
+                 * on all channels.
+                 */
+                void assembleParameterNumbers(bool enabled = true);
+
+                // arrival time of the message being dispatched
+                uint64_t messageTime = 0;
+
+                /**
+                 * @param time arrival time (see latencyNow()), 0 = unknown (now)
+                 */
+                void receivedMessage(const unsigned char * bytes, std::size_t size, uint64_t time);
+
+                void receivedMessage(const libremidi::message& message){
+                    receivedMessage(message.bytes.data(), message.bytes.size(), (uint64_t)message.timestamp);
+                }
 
             public:
+
+                Delegate();
+
+                bool handles(unsigned char status) const {
+                    return handlers[status] != nullptr;
+                }
+
+                /**
+                 * Within the received*() handlers: monotonic time (see latencyNow()) in ns the message arrived at,
+                 * as reported by the MIDI backend rather than the time it is being handled.
+                 */
+                uint64_t getMessageTime() const {
+                    return messageTime;
+                }
+
                 virtual void receivedNoteOn(int channel, int note, int velocity){}
                 virtual void receivedNoteOff(int channel, int note, int velocity){}
                 virtual void receivedControlChange(int channel, int cc, int value){}
@@ -42,15 +180,75 @@ namespace LisaDeskbridge {
                 virtual void receivedProgramChange(int channel, int program){}
                 virtual void receivedAftertouch(int channel, int pressure){}
                 virtual void receivedPitchBend(int channel, int bend){}
+
+                /**
+                 * @param cc MSB controller number (0-31)
+                 * @param value 14 bit (0 - 16383)
+                 */
+                virtual void receivedControlChange14(int channel, int cc, int value){}
+
+                /**
+                 * @param parameter 14 bit parameter number
+                 * @param value 14 bit (0 - 16383)
+                 * @param registered RPN (vs NRPN)
+                 */
+                virtual void receivedParameterChange(int channel, int parameter, int value, bool registered){}
             };
 
+        public:
+
+            static constexpr unsigned int kMaxCaptureId = 16;
+
         protected:
 
             Delegate * midiReceiverDelegate;
 
+            // receivers by capture id
+            static MidiReceiver * receivers[kMaxCaptureId];
+            static std::atomic<unsigned int> receiverCount;
+
+            // order of construction (within the process), identifies the receiver in captures
+            unsigned int captureId;
+
+            // if set, messages are handed over to (and delivered on) the reactor's thread
+            static std::atomic<Reactor*> reactor;
+
+            static void deliver(void * receiver, const Reactor::Task & task);
+
+            void received(const libremidi::message& message);
+
+            // gives up on pending 14-bit MSBs (if the delegate assembles them)
+            std::thread * pairThread = nullptr;
+            Reactor * pairReactor = nullptr;
+            int pairTimer = -1; // on reactor
+
+            void runPairTimer();
+
         public:
 
             MidiReceiver(Delegate &delegate);
+            ~MidiReceiver();
+
+            unsigned int getCaptureId(){ return captureId; }
+
+            /**
+             * @return receiver with given capture id (if it still exists)
+             */
+            static MidiReceiver * byCaptureId(unsigned int id);
+
+            /**
+             * Hands a message to the delegate as if it had been received on the port (capturing it, if enabled).
+             */
+            void inject(const libremidi::message& message);
+
+            static void setReactor(Reactor * reactor);
+
+            /**
+             * Starts giving up on 14-bit MSBs whose LSB does not follow within kPairTimeout, on the reactor (if set)
+             * or on a thread of its own. Done by the port implementations' start() resp. stop().
+             */
+            void startPairTimer();
+            void stopPairTimer();
 
     };
 
@@ -19,8 +19,16 @@
 #ifndef LISA_DESKBRIDGE_MIDISENDER_H
 #define LISA_DESKBRIDGE_MIDISENDER_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 #include <libremidi/libremidi.hpp>
 
+#include "MpscQueue.h"
+#include "PeriodicTask.h"
+#include "Reactor.h"
+
 namespace LisaDeskbridge {
 
     class MidiSender {
@@ -35,19 +43,79 @@ namespace LisaDeskbridge {
             virtual void sendChannelPressure(int channel, int pressure){};
             virtual void sendPitchBend(int channel, int bend){};
 
+            /**
+             * A control change reflecting current state (eg. a fader position), of which only the latest value matters:
+             * it may be dropped in favour of a later one and sent out of order with other messages.
+             */
+            virtual void sendFeedbackControlChange(int channel, int cc, int value){
+                sendControlChange(channel, cc, value);
+            };
+
     };
 
+    /**
+     * Sends either right away (on the calling thread) or, once the output stage is started, from a single flush
+     * at a limited rate: feedback control changes are reduced to the latest value per (channel, controller),
+     * anything else is queued in order. Callers then merely do an atomic store resp. a lock-free push, never blocking.
+     */
     class MidiSender_Single_Impl : public MidiSender {
 
+        public:
+
+            static constexpr unsigned int kOutputRateDefault = 100; // Hz
+            static constexpr unsigned int kOutputRateMax = 1000; // Hz
+
+            static constexpr std::size_t kOutputQueueSize = 256;
+
         protected:
 
             libremidi::midi_out midiOut;
 
+            struct Message {
+                uint8_t size;
+                unsigned char bytes[3];
+            };
+
+            // latest feedback value by (channel * 128 + controller) resp. which of them are to be sent
+            std::atomic<uint8_t> ccValues[16 * 128];
+            std::atomic<uint64_t> ccDirty[16 * 128 / 64];
+
+            // anything else, in order
+            MpscQueue<Message, kOutputQueueSize> outputQueue;
+
+            std::atomic<bool> outputStarted{false};
+            PeriodicTask outputTask;
+            Reactor * outputReactor = nullptr;
+            int outputTimer = -1; // on reactor
+
+            void send(unsigned char status, unsigned char data1, unsigned char data2, uint8_t size = 3);
+            void sendNow(const unsigned char * bytes, std::size_t size);
+
         public:
 
+            MidiSender_Single_Impl();
+            ~MidiSender_Single_Impl();
+
+            /**
+             * Starts the output stage, flushing rate times per second (on the reactor's thread, if given).
+             * A rate of 0 keeps sending right away.
+             */
+            void startOutput(unsigned int rate, Reactor * reactor = nullptr);
+
+            /**
+             * Stops the output stage (sending anything left over), sends right away hereafter.
+             */
+            void stopOutput();
+
+            /**
+             * Sends what is queued, must not be called concurrently (the output stage calls it itself).
+             */
+            void flushOutput();
+
             void sendNoteOn(int channel, int note, int velocity);
             void sendNoteOff(int channel, int note, int velocity);
             void sendControlChange(int channel, int cc, int value);
+            void sendFeedbackControlChange(int channel, int cc, int value);
             void sendAftertouch(int channel, int note, int pressure);
             void sendProgramChange(int channel, int program);
             void sendChannelPressure(int channel, int pressure);
@@ -0,0 +1,133 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_MPSCQUEUE_H
+#define LISA_DESKBRIDGE_MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace LisaDeskbridge {
+
+    /**
+     * Bounded lock-free multi-producer single-consumer queue.
+     *
+     * Every slot carries a sequence number telling whether it is free to be written (by the producer that
+     * claimed its position) or ready to be read (by the consumer), see Dmitry Vyukov's bounded MPMC queue.
+     * Elements are filled and consumed in place, so large elements are never copied around.
+     */
+    template<typename T, std::size_t Capacity>
+    class MpscQueue {
+
+            static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        protected:
+
+            struct Slot {
+                std::atomic<std::size_t> sequence;
+                T value;
+            };
+
+            alignas(64) std::atomic<std::size_t> enqueuePos;
+            alignas(64) std::atomic<std::size_t> dequeuePos;
+
+            alignas(64) Slot slots[Capacity];
+
+        public:
+
+            MpscQueue(){
+                for(std::size_t i = 0; i < Capacity; i++){
+                    slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+                enqueuePos.store(0, std::memory_order_relaxed);
+                dequeuePos.store(0, std::memory_order_relaxed);
+            }
+
+            static constexpr std::size_t capacity(){ return Capacity; }
+
+            /**
+             * Approximate number of queued elements.
+             */
+            std::size_t size() const {
+                std::size_t enq = enqueuePos.load(std::memory_order_relaxed);
+                std::size_t deq = dequeuePos.load(std::memory_order_relaxed);
+                return enq > deq ? enq - deq : 0;
+            }
+
+            /**
+             * Consumer side only.
+             */
+            bool empty() const {
+                std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+                return slots[pos & (Capacity - 1)].sequence.load(std::memory_order_acquire) != pos + 1;
+            }
+
+            /**
+             * Claims a slot and lets fill(T&) write the element, fails (without calling fill) if the queue is full.
+             * Safe to be called from any number of threads.
+             */
+            template<typename Fill>
+            bool push(Fill fill){
+                std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+                for(;;){
+                    Slot & slot = slots[pos & (Capacity - 1)];
+                    std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+                    std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+
+                    if (diff == 0){
+                        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                            fill(slot.value);
+                            slot.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                        // pos was updated, retry
+                    } else if (diff < 0){
+                        // full
+                        return false;
+                    } else {
+                        pos = enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /**
+             * Passes the oldest element to consume(T&), fails if the queue is empty.
+             * Must only be called from a single thread.
+             */
+            template<typename Consume>
+            bool pop(Consume consume){
+                std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+                Slot & slot = slots[pos & (Capacity - 1)];
+
+                if (slot.sequence.load(std::memory_order_acquire) != pos + 1){
+                    return false;
+                }
+
+                consume(slot.value);
+
+                slot.sequence.store(pos + Capacity, std::memory_order_release);
+                dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+                return true;
+            }
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_MPSCQUEUE_H
@@ -0,0 +1,294 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_OSCADDRESSES_H
+#define LISA_DESKBRIDGE_OSCADDRESSES_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "LisaController.h"
+
+namespace LisaDeskbridge {
+
+    /**
+     * An expanded OSC address pattern (zero-padded).
+     */
+    struct OscAddress {
+        static constexpr size_t kCapacity = 36;
+
+        char str[kCapacity];
+    };
+
+    inline constexpr uint32_t oscPaddedSize(size_t length){
+        // string + terminating zero, rounded up to multiple of 4
+        return (uint32_t)((length + 4) & ~((size_t)3));
+    }
+
+    // NOTE: order must match kSourceAddressFormats
+    enum SourceAddress_t {
+        SourceAddressControlPan,
+        SourceAddressControlWidth,
+        SourceAddressControlDistance,
+        SourceAddressControlElevation,
+        SourceAddressControlAuxSend,
+
+        SourceAddressPan,
+        SourceAddressWidth,
+        SourceAddressDistance,
+        SourceAddressElevation,
+        SourceAddressPanSpread,
+        SourceAddressAuxSend,
+
+        SourceAddressAllParameters,
+
+        SourceAddressRelativePan,
+        SourceAddressRelativeWidth,
+        SourceAddressRelativeDistance,
+        SourceAddressRelativeElevation,
+        SourceAddressRelativePanSpread,
+        SourceAddressRelativeAuxSend,
+
+        SourceAddressSolo,
+        SourceAddressStaticDelayValue,
+        SourceAddressSnapToSpeaker,
+
+        SourceAddressOptGain,
+        SourceAddressOptHpf,
+        SourceAddressOptDelayEnabled,
+        SourceAddressOptDelayMode,
+        SourceAddressOptReverbEarly,
+        SourceAddressOptReverbCluster,
+        SourceAddressOptReverbLate,
+        SourceAddressOptDirectSound,
+
+        SourceAddressChangeSelection,
+        SourceAddressSetSelection,
+
+        SourceAddressCount
+    };
+
+    // NOTE: order must match kGroupAddressFormats
+    enum GroupAddress_t {
+        GroupAddressPan,
+        GroupAddressWidth,
+        GroupAddressDistance,
+        GroupAddressElevation,
+        GroupAddressAuxSend,
+        GroupAddressPanSpread,
+
+        GroupAddressRelativePan,
+        GroupAddressRelativeWidth,
+        GroupAddressRelativeDistance,
+        GroupAddressRelativeElevation,
+        GroupAddressRelativeAuxSend,
+        GroupAddressRelativePanSpread,
+
+        GroupAddressSetSelection,
+
+        GroupAddressCount
+    };
+
+    // NOTE: order must match kFxAddressFormats
+    enum FxAddress_t {
+        FxAddressStart,
+        FxAddressRestart,
+        FxAddressStop,
+
+        FxAddressCount
+    };
+
+    // NOTE: order must match kUserFaderAddressFormats
+    enum UserFaderAddress_t {
+        UserFaderAddressGain,
+        UserFaderAddressPos,
+        UserFaderAddressMute,
+
+        UserFaderAddressCount
+    };
+
+    // NOTE: order must match kDeviceAddressFormats
+    enum DeviceAddress_t {
+        DeviceAddressRegister,
+        DeviceAddressDelete,
+        DeviceAddressName,
+        DeviceAddressEnableSending,
+        DeviceAddressEnableReceiving,
+        DeviceAddressCoordFormat,
+        DeviceAddressMasterGainControl,
+
+        DeviceAddressCount
+    };
+
+    /**
+     * Table of all id-parametrized OSC addresses (sources, groups, snapshots, ...), expanded once on first use
+     * such that message setters only have to look up their address instead of formatting it.
+     *
+     * Snapshot and reverb ids are not bounded by the protocol, only the first kMaxSnapshotId resp. kMaxReverbId
+     * are tabled (which covers anything a MIDI note/program can select), use expand() for anything beyond.
+     */
+    class OscAddressTable {
+
+        public:
+
+            static constexpr unsigned int kMaxSourceId     = 96;
+            static constexpr unsigned int kMaxGroupId      = 96;
+            static constexpr unsigned int kMaxSnapshotId   = 128;
+            static constexpr unsigned int kMaxReverbId     = 128;
+            static constexpr unsigned int kMaxFxId         = 32;
+            static constexpr unsigned int kMaxUserFader    = 2;
+            static constexpr unsigned int kMaxDeviceId     = 10;
+
+        protected:
+
+            OscAddress sources_[kMaxSourceId][SourceAddressCount];
+            OscAddress groups_[kMaxGroupId][GroupAddressCount];
+            OscAddress snapshots_[kMaxSnapshotId];
+            OscAddress reverbs_[kMaxReverbId];
+            OscAddress fxs_[kMaxFxId][FxAddressCount];
+            OscAddress userFaders_[kMaxUserFader][UserFaderAddressCount];
+            OscAddress devices_[kMaxDeviceId][DeviceAddressCount];
+
+            OscAddressTable();
+
+        public:
+
+            static const OscAddressTable & instance();
+
+            /**
+             * Expands given single-id format into address.
+             */
+            static void expand(OscAddress & address, const char * format, unsigned int id);
+
+            const OscAddress & source(SourceId_t src, SourceAddress_t address) const {
+                assert(isValidSourceId(src));
+                return sources_[src - 1][address];
+            }
+
+            const OscAddress & group(GroupId_t grp, GroupAddress_t address) const {
+                assert(isValidGroupId(grp));
+                return groups_[grp - 1][address];
+            }
+
+            bool hasSnapshot(SnapshotId_t snapshot) const {
+                return (1 <= snapshot && snapshot <= kMaxSnapshotId);
+            }
+            const OscAddress & snapshot(SnapshotId_t snapshot) const {
+                assert(hasSnapshot(snapshot));
+                return snapshots_[snapshot - 1];
+            }
+
+            bool hasReverb(ReverbId_t reverb) const {
+                return (1 <= reverb && reverb <= kMaxReverbId);
+            }
+            const OscAddress & reverb(ReverbId_t reverb) const {
+                assert(hasReverb(reverb));
+                return reverbs_[reverb - 1];
+            }
+
+            const OscAddress & fx(FxId_t fx, FxAddress_t address) const {
+                assert(isValidFxId(fx));
+                return fxs_[fx - 1][address];
+            }
+
+            const OscAddress & userFader(int fader, UserFaderAddress_t address) const {
+                assert(1 <= fader && fader <= (int)kMaxUserFader);
+                return userFaders_[fader - 1][address];
+            }
+
+            const OscAddress & device(DeviceId_t device, DeviceAddress_t address) const {
+                assert(isValidDeviceId(device));
+                return devices_[device - 1][address];
+            }
+    };
+
+
+    // Addresses received from L-ISA Controller (see kMsgRx*)
+    enum RxAddress_t {
+        RxAddressUnknown            = 0,
+        RxAddressMasterGain         = 1,
+        RxAddressMasterFaderPos     = 2,
+        RxAddressReverbGain         = 3,
+        RxAddressReverbFaderPos     = 4,
+        RxAddressPong               = 5,
+        RxAddressSourcePan          = 6,
+        RxAddressSourceWidth        = 7,
+        RxAddressSourceDistance     = 8,
+        RxAddressSourceElevation    = 9,
+        RxAddressSourceAuxSend      = 10,
+
+        RxAddressCount              = 11
+    };
+
+    struct RxAddress {
+        RxAddress_t type;
+        unsigned int id; // source id (if any)
+    };
+
+    /**
+     * Identifies a received address in a single scan (instead of trying every known pattern in turn).
+     * Source addresses (/ext/src/<id>/<p|w|d|e|s>) must be complete, ie without any trailing characters.
+     */
+    RxAddress parseRxAddress(const char * address);
+
+
+    // Rough classification of messages (for statistics)
+    enum MessageClass_t {
+        MessageClassSourceParam     = 0, // source parameters (including selected sources)
+        MessageClassGroupParam      = 1,
+        MessageClassSelection       = 2,
+        MessageClassSnapshot        = 3,
+        MessageClassFader           = 4, // master, reverb, monitor and user faders
+        MessageClassFlags           = 5, // control flags and source processing config
+        MessageClassDevice          = 6, // device registration, ping
+        MessageClassOther           = 7,
+
+        MessageClassCount           = 8
+    };
+
+    const char * messageClassName(MessageClass_t cls);
+
+    /**
+     * Classifies any address sent to L-ISA Controller by looking at its first path component(s).
+     */
+    MessageClass_t classifyAddress(const char * address);
+
+    inline MessageClass_t classifyRxAddress(RxAddress_t address){
+        switch(address){
+            case RxAddressMasterGain:
+            case RxAddressMasterFaderPos:
+            case RxAddressReverbGain:
+            case RxAddressReverbFaderPos:
+                return MessageClassFader;
+            case RxAddressSourcePan:
+            case RxAddressSourceWidth:
+            case RxAddressSourceDistance:
+            case RxAddressSourceElevation:
+            case RxAddressSourceAuxSend:
+                return MessageClassSourceParam;
+            case RxAddressPong:
+                return MessageClassDevice;
+            default:
+                return MessageClassOther;
+        }
+    }
+
+}
+
+#endif //LISA_DESKBRIDGE_OSCADDRESSES_H
@@ -0,0 +1,63 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_PERIODICTASK_H
+#define LISA_DESKBRIDGE_PERIODICTASK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace LisaDeskbridge {
+
+    /**
+     * Runs a callback at a fixed rate on its own thread (until stopped).
+     */
+    class PeriodicTask {
+
+        public:
+
+            typedef std::function<void()> Callback;
+
+        protected:
+
+            std::thread * thread = nullptr;
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool stopRequested = false;
+
+            void run(std::chrono::microseconds period, Callback callback);
+
+        public:
+
+            ~PeriodicTask(){
+                stop();
+            }
+
+            bool isRunning(){ return thread != nullptr; }
+
+            void start(std::chrono::microseconds period, Callback callback);
+            void stop();
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_PERIODICTASK_H
@@ -0,0 +1,130 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LISA_DESKBRIDGE_REACTOR_H
+#define LISA_DESKBRIDGE_REACTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "MpscQueue.h"
+
+namespace LisaDeskbridge {
+
+    /**
+     * Single-threaded event loop (epoll, Linux only): file descriptors, timers and tasks posted from other
+     * threads are all handled by the thread calling run().
+     *
+     * Only post() and stop() may be called from other threads, anything else only from the loop's thread
+     * (or while the loop is not running).
+     */
+    class Reactor {
+
+        public:
+
+            typedef std::function<void()> Callback;
+
+            static constexpr std::size_t kTaskDataSize = 32;
+            static constexpr std::size_t kTaskQueueCapacity = 1024;
+
+            /**
+             * A small, self-contained piece of work handed over from another thread (eg. a MIDI message).
+             */
+            struct Task {
+                void (*run)(void * context, const Task & task);
+                void * context;
+                uint64_t ingress; // of the posting thread, see Latency.h
+                uint8_t size;
+                unsigned char data[kTaskDataSize];
+            };
+
+            typedef void (*TaskFunction)(void * context, const Task & task);
+
+        protected:
+
+            int epollFd = -1;
+            int wakeFd = -1;
+
+            struct Watch {
+                int fd;
+                Callback callback;
+                bool removed;
+            };
+
+            std::map<int, Watch*> watches;
+            std::vector<Watch*> removedWatches;
+
+            MpscQueue<Task, kTaskQueueCapacity> tasks;
+            std::atomic<bool> wakePending{false};
+            std::atomic<uint64_t> tasksDropped{0};
+
+            std::atomic<bool> stopRequested{false};
+
+            void runTasks();
+
+        public:
+
+            ~Reactor(){
+                close();
+            }
+
+            /**
+             * @return false if not supported (on this platform) or out of resources
+             */
+            bool open();
+            void close();
+
+            bool isOpen(){ return epollFd != -1; }
+
+            /**
+             * Calls callback whenever fd is readable (level-triggered).
+             */
+            bool watch(int fd, Callback callback);
+            void unwatch(int fd);
+
+            /**
+             * Calls callback every period.
+             * @return timer id (for removeTimer()), -1 on failure
+             */
+            int addTimer(std::chrono::microseconds period, Callback callback);
+            void removeTimer(int timer);
+
+            /**
+             * Queues a call of function(context, task) on the loop's thread, data (at most kTaskDataSize bytes) is
+             * copied into the task. Never blocks, fails if the queue is full.
+             */
+            bool post(TaskFunction function, void * context, const void * data, std::size_t size);
+
+            uint64_t getDroppedTasks(){ return tasksDropped.load(std::memory_order_relaxed); }
+
+            /**
+             * Runs until stop() is called.
+             */
+            void run();
+            void stop();
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_REACTOR_H
@@ -0,0 +1,145 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISA_DESKBRIDGE_RELATIVECOALESCER_H
+#define LISA_DESKBRIDGE_RELATIVECOALESCER_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "OscAddresses.h"
+
+namespace LisaDeskbridge {
+
+    enum RelativeParam_t {
+        RelativePan         = 0,
+        RelativeWidth       = 1,
+        RelativeDistance    = 2,
+        RelativeElevation   = 3,
+        RelativePanSpread   = 4,
+        RelativeAuxSend     = 5,
+
+        RelativeParamCount  = 6
+    };
+
+    enum RelativeTarget_t {
+        RelativeTargetSelectedSources   = 0,
+        RelativeTargetSource            = 1,
+        RelativeTargetGroup             = 2
+    };
+
+    /**
+     * Sums up relative parameter changes per (target, parameter) until they are flushed.
+     *
+     * add() may be called from any number of threads concurrently with flush(), neither takes a lock:
+     * every slot is an atomic float and pending slots are marked in an atomic dirty bitmap.
+     */
+    class RelativeCoalescer {
+
+        public:
+
+            // selected sources + sources + groups
+            static constexpr std::size_t kTargetCount = 1 + OscAddressTable::kMaxSourceId + OscAddressTable::kMaxGroupId;
+            static constexpr std::size_t kSlotCount = kTargetCount * RelativeParamCount;
+            static constexpr std::size_t kDirtyWordCount = (kSlotCount + 63) / 64;
+
+        protected:
+
+            std::atomic<float> sums[kSlotCount];
+            std::atomic<uint64_t> dirty[kDirtyWordCount];
+
+            // ingress tag (see Latency.h) of the first delta since the last flush
+            std::atomic<uint64_t> ingress[kSlotCount];
+
+            std::atomic<bool> pending;
+
+            static std::size_t slotOf(RelativeTarget_t target, unsigned int id, RelativeParam_t param){
+                std::size_t t = 0;
+                if (target == RelativeTargetSource){
+                    assert(isValidSourceId(id));
+                    t = id;
+                } else if (target == RelativeTargetGroup){
+                    assert(isValidGroupId(id));
+                    t = OscAddressTable::kMaxSourceId + id;
+                }
+                return t * RelativeParamCount + param;
+            }
+
+        public:
+
+            RelativeCoalescer();
+
+            bool hasPending(){
+                return pending.load(std::memory_order_acquire);
+            }
+
+            void add(RelativeTarget_t target, unsigned int id, RelativeParam_t param, float delta, uint64_t ingressTag = 0);
+
+            /**
+             * Hands every pending (non-zero) sum to callback(target, id, param, sum, ingressTag) and resets it.
+             * Sums are clamped to the valid relative range.
+             */
+            template<typename Callback>
+            void flush(Callback callback){
+                if (!pending.exchange(false, std::memory_order_acq_rel)){
+                    return;
+                }
+
+                for(std::size_t w = 0; w < kDirtyWordCount; w++){
+                    uint64_t bits = dirty[w].exchange(0, std::memory_order_acq_rel);
+
+                    while(bits){
+                        int b = __builtin_ctzll(bits);
+                        bits &= bits - 1;
+
+                        std::size_t slot = w * 64 + b;
+
+                        float sum = sums[slot].exchange(0.0f, std::memory_order_acq_rel);
+                        uint64_t tag = ingress[slot].exchange(0, std::memory_order_relaxed);
+
+                        // a concurrent add() may have raced us to an already flushed slot
+                        if (sum == 0.0f){
+                            continue;
+                        }
+
+                        if (sum < -1.0f){
+                            sum = -1.0f;
+                        } else if (1.0f < sum){
+                            sum = 1.0f;
+                        }
+
+                        std::size_t t = slot / RelativeParamCount;
+                        RelativeParam_t param = (RelativeParam_t)(slot % RelativeParamCount);
+
+                        if (t == 0){
+                            callback(RelativeTargetSelectedSources, 0, param, sum, tag);
+                        } else if (t <= OscAddressTable::kMaxSourceId){
+                            callback(RelativeTargetSource, (unsigned int)t, param, sum, tag);
+                        } else {
+                            callback(RelativeTargetGroup, (unsigned int)(t - OscAddressTable::kMaxSourceId), param, sum, tag);
+                        }
+                    }
+                }
+            }
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_RELATIVECOALESCER_H
@@ -0,0 +1,114 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LISA_DESKBRIDGE_TRANSPORT_H
+#define LISA_DESKBRIDGE_TRANSPORT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <netinet/in.h>
+
+namespace LisaDeskbridge {
+
+    /**
+     * Where the proxy's encoded datagrams go. send() resp. sendBatch() are only ever called from the proxy's
+     * TX thread.
+     */
+    class Transport {
+        public:
+            struct Buffer {
+                const char * data;
+                std::size_t size;
+            };
+
+            virtual ~Transport(){}
+
+            virtual void send(const char * data, std::size_t size) = 0;
+
+            /**
+             * Sends the given datagrams in order.
+             * @return number of system calls it took
+             */
+            virtual std::size_t sendBatch(const Buffer * buffers, std::size_t count){
+                for(std::size_t i = 0; i < count; i++){
+                    send(buffers[i].data, buffers[i].size);
+                }
+                return count;
+            }
+    };
+
+    /**
+     * Sends every datagram to several L-ISA Controllers (eg. main and backup): the datagram is encoded once and,
+     * on Linux, handed to all targets with a single sendmmsg() call (as are batches).
+     */
+    class UdpFanoutTransport : public Transport {
+        public:
+            static constexpr std::size_t kMaxTargets = 4;
+            static constexpr std::size_t kMaxBatch = 32;
+        protected:
+            int fd = -1;
+            struct sockaddr_in targets[kMaxTargets];
+            std::size_t targetCount = 0;
+            std::atomic<uint64_t> errors{0};
+        public:
+            UdpFanoutTransport();
+            ~UdpFanoutTransport();
+
+            /**
+             * @return false if there are too many targets or the address is invalid
+             */
+            bool addTarget(const char * address, unsigned short port);
+
+            void send(const char * data, std::size_t size);
+            std::size_t sendBatch(const Buffer * buffers, std::size_t count);
+
+            // failed sends (per target)
+            uint64_t getErrors(){ return errors.load(std::memory_order_relaxed); }
+    };
+
+    /**
+     * Sends to the L-ISA Controller (the default).
+     */
+    class UdpTransport : public UdpFanoutTransport {
+        public:
+            UdpTransport(const char * address, unsigned short port);
+    };
+
+    /**
+     * Discards everything, only counting datagrams and bytes (benchmarks, dry runs).
+     */
+    class NullTransport : public Transport {
+        protected:
+            std::atomic<uint64_t> datagrams{0};
+            std::atomic<uint64_t> bytes{0};
+        public:
+            void send(const char * data, std::size_t size){
+                datagrams.fetch_add(1, std::memory_order_relaxed);
+                bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+
+            uint64_t getDatagrams(){ return datagrams.load(std::memory_order_relaxed); }
+            uint64_t getBytes(){ return bytes.load(std::memory_order_relaxed); }
+    };
+
+}
+
+#endif //LISA_DESKBRIDGE_TRANSPORT_H
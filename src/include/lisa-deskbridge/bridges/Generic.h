@@ -69,6 +69,12 @@ namespace LisaDeskbridge {
             void receivedNoteOn(int channel, int note, int velocity);
             void receivedNoteOff(int channel, int note, int velocity);
             void receivedControlChange(int channel, int cc, int value);
+            void receivedControlChange14(int channel, int cc, int value);
+
+        protected:
+
+            // master, reverb, monitor, user 1, user 2 fader on CC 1 - 5 (channel 2)
+            void faderChange(int cc, float pos);
 
         protected: // LisaDeskbridge::LisaControllerProxy::Delegate
 
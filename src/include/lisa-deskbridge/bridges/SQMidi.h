@@ -33,7 +33,6 @@ namespace LisaDeskbridge {
                 static constexpr char kName[] = "SQ-Midi";
 
                 static constexpr char kSQ6MidiControlPortName[] = "MIDI Control 1";
-                static constexpr float kDefaultRelativeStepSize = 0.0025;
 
                 static constexpr char helpOpts[] = "\tSQ-Midi Options:\n"
                                                    "\t\t midiin    Name of MIDI In port to use (default: 'MIDI Control 1')\n"
@@ -54,6 +53,9 @@ namespace LisaDeskbridge {
 
                         MixingStationDelegate(SQMidi &sq){
                             sq6 = &sq;
+
+                            ignoreAll();
+                            handle(MidiTypeNoteOn, 1);
                         }
 
                         void receivedNoteOn(int channel, int note, int velocity);
@@ -71,12 +73,33 @@ namespace LisaDeskbridge {
 
                         SQMidiControlDelegate(SQMidi &sq){
                             sq6 = &sq;
+
+                            ignoreAll();
+                            for(int channel = 1; channel <= 4; channel++){
+                                handle(MidiTypeNoteOn, channel);
+                            }
+                            handle(MidiTypeNoteOff, 1);
+                            handle(MidiTypeControlChange, 1);
+                            handle(MidiTypeControlChange, 2);
+                            handle(MidiTypeProgramChange, 1);
+
+                            if (sq.hiresFaders_){
+                                for(int cc = 0; cc <= 4; cc++){
+                                    assembleControlChange14(cc, 2);
+                                }
+                            }
                         }
 
                         void receivedNoteOn(int channel, int note, int velocity);
                         void receivedNoteOff(int channel, int note, int velocity);
                         void receivedControlChange(int channel, int cc, int value);
+                        void receivedControlChange14(int channel, int cc, int value);
                         void receivedProgramChange(int channel, int program);
+
+                    protected:
+
+                        // master, reverb, monitor, user 1, user 2 fader on CC 0 - 4 (channel 2)
+                        void faderChange(int cc, float pos);
                 };
 
 
@@ -21,6 +21,8 @@
 
 
 #include "../Bridge.h"
+#include "../Capture.h"
+#include "../Metrics.h"
 #include "sqmixmitm/DiscoveryResponder.h"
 #include "sqmixmitm/MixMitm.h"
 #include "../MidiClient.h"
@@ -34,7 +36,6 @@ namespace LisaDeskbridge {
 
             static constexpr char kName[] = "SQ-Mitm";
 
-            static constexpr float kDefaultRelativeStepSize = 0.0025;
 
             static constexpr char helpOpts[] = "\tSQ-Mitm Options:\n"
                                                "\t\t mixer-ip=<mixer-ip>               IP of mixer (REQUIRED)\n"
@@ -83,8 +84,21 @@ namespace LisaDeskbridge {
             bool startImpl();
             void stopImpl();
 
+            /**
+             * Hands a mixer event from the MITM service's thread on to onMixerEvent(), through the event loop if
+             * there is one.
+             */
+            void postMixerEvent(MixerEvent_t type, int arg0, int arg1, int arg2 = 0, int arg3 = 0);
+
         public:
 
+            /**
+             * Dispatches a mixer event (as passed on by the MITM service, or from a capture) to the handlers below.
+             * Arguments by type: ChannelSelect (channel, on), SoftRotary/SoftKey (channel, type, value1, value2),
+             * FaderLevel (channel, value).
+             */
+            void onMixerEvent(MixerEvent_t type, int arg0, int arg1, int arg2 = 0, int arg3 = 0);
+
             void onSelectedChannel(int channel);
 
             void onMidiEvent(int channel, int type, int value1, int value2);
@@ -92,11 +106,15 @@ namespace LisaDeskbridge {
             void onMidiNoteOn(int channel, int note, int velocity);
             void onMidiNoteOff(int channel, int note, int velocity);
             void onMidiControlChange(int channel, int cc, int value);
+            void onMidiControlChange14(int channel, int cc, int value);
             void onMidiProgramChange(int channel, int program);
 
             void onMidiFaderLevel(int channel, int value);
             void onMidiFaderMute(int channel);
 
+            // master, reverb, monitor, user 1, user 2 fader (0 - 4)
+            void faderChange(int fader, float pos);
+
         public: // LisaDeskbridge::MidiReceiver::Delegate
 
             void receivedNoteOn(int channel, int note, int velocity){
@@ -111,6 +129,10 @@ namespace LisaDeskbridge {
                 onMidiControlChange(channel, cc, value);
             }
 
+            void receivedControlChange14(int channel, int cc, int value){
+                onMidiControlChange14(channel, cc, value);
+            }
+
             void receivedPitchBend(int channel, int bend);
 
 
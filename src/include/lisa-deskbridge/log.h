@@ -19,9 +19,34 @@
 #ifndef LISA_DESKBRIDGE_LOG_H
 #define LISA_DESKBRIDGE_LOG_H
 
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <functional>
 
+/**
+ * Log statements more verbose than this are compiled out entirely (when using the LISA_LOG* macros),
+ * eg -DLISA_DESKBRIDGE_COMPILED_LOG_LEVEL=2 drops all debug messages.
+ */
+#ifndef LISA_DESKBRIDGE_COMPILED_LOG_LEVEL
+#define LISA_DESKBRIDGE_COMPILED_LOG_LEVEL 3
+#endif
+
+/**
+ * Preferred way to log: the arguments are only evaluated (and log() called) if the message would
+ * actually be output.
+ */
+#define LISA_LOG(level, ...) \
+    do { \
+        if ((int)(level) <= LISA_DESKBRIDGE_COMPILED_LOG_LEVEL && LisaDeskbridge::isLogEnabled(level)){ \
+            LisaDeskbridge::log((level), __VA_ARGS__); \
+        } \
+    } while(0)
+
+#define LISA_LOG_ERROR(...)     LISA_LOG(LisaDeskbridge::LogLevelError, __VA_ARGS__)
+#define LISA_LOG_INFO(...)      LISA_LOG(LisaDeskbridge::LogLevelInfo, __VA_ARGS__)
+#define LISA_LOG_DEBUG(...)     LISA_LOG(LisaDeskbridge::LogLevelDebug, __VA_ARGS__)
+
 namespace LisaDeskbridge {
 
     enum LogLevel {
@@ -40,8 +65,26 @@ namespace LisaDeskbridge {
 
     void defaultLog(LogLevel level, const char * msg, ...);
 
+    // most verbose level that is possibly output (custom log functions do their own filtering, thus get everything)
+    extern std::atomic<int> logGate;
+
+    inline bool isLogEnabled(LogLevel level){
+        return (int)level <= logGate.load(std::memory_order_relaxed);
+    }
+
     void logError(const char * msg, ...);
 
+    /**
+     * In async mode log() only copies the format and its arguments into a preallocated queue, formatting and
+     * output (through the log function set) is done by a background thread. Never blocks, if the queue is full
+     * the message is dropped (and counted).
+     * NOTE formats must be string literals (or otherwise outlive the call), strings arguments are copied.
+     */
+    void startAsyncLog();
+    void stopAsyncLog();
+    bool isAsyncLog();
+    uint64_t getDroppedLogCount();
+
     extern LogFunction log;
 }
 
@@ -0,0 +1,96 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Assembly of 14-bit control changes: an MSB whose LSB got lost is still delivered (by the receiver's timer),
+ * without any further message arriving.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "lisa-deskbridge/MidiReceiver.h"
+
+using namespace LisaDeskbridge;
+
+class PairDelegate : public MidiReceiver::Delegate {
+
+    public:
+
+        std::atomic<int> count{0};
+        std::atomic<int> lastValue{-1};
+
+        PairDelegate(){
+            assembleControlChange14(1, 2);
+        }
+
+        void receivedControlChange14(int channel, int cc, int value) override {
+            if (channel == 2 && cc == 1){
+                lastValue.store(value);
+                count.fetch_add(1);
+            }
+        }
+};
+
+static void send(MidiReceiver & receiver, unsigned char cc, unsigned char value){
+    libremidi::message message;
+    message.bytes = {0xB1, cc, value}; // channel 2
+    message.timestamp = 0;
+
+    receiver.inject(message);
+}
+
+static bool check(bool condition, const char * what){
+    if (!condition){
+        std::fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+int main(){
+    PairDelegate delegate;
+    MidiReceiver receiver(delegate);
+    receiver.startPairTimer();
+
+    // first MSB goes out right away, the LSB refines it (the controller is now known to send LSBs)
+    send(receiver, 1, 64);
+    send(receiver, 33, 5);
+
+    bool ok = check(delegate.count == 2 && delegate.lastValue == ((64 << 7) | 5), "pair delivered");
+
+    // MSB waits for its LSB, which is dropped
+    send(receiver, 1, 100);
+
+    ok &= check(delegate.count == 2, "MSB held back for its LSB");
+
+    auto timeout = std::chrono::nanoseconds(MidiReceiver::Delegate::kPairTimeout);
+    auto deadline = std::chrono::steady_clock::now() + 10 * timeout;
+    while(delegate.count == 2 && std::chrono::steady_clock::now() < deadline){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ok &= check(delegate.count == 3 && delegate.lastValue == (100 << 7), "MSB delivered after timeout");
+
+    if (ok){
+        std::printf("ok\n");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,389 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+ * Micro-benchmarks of the hot paths from (MIDI/mixer) input to OSC output and of OSC input:
+ * encoding of messages to L-ISA Controller, ProcessMessage() for every kMsgRx* address, parsing of received
+ * addresses (parseRxAddress() vs the former strcmp/sscanf chain), MIDI decoding and the SQ-Midi/SQ-Mitm mapping
+ * handlers.
+ *
+ * Nothing is actually sent (the proxies are started detached on a NullTransport) and no MIDI ports or mixer
+ * connections are opened. Results are written to stdout as JSON, to compare builds/releases.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "lisa-deskbridge/LisaController.h"
+#include "lisa-deskbridge/LisaControllerProxy.h"
+#include "lisa-deskbridge/MidiReceiver.h"
+#include "lisa-deskbridge/OscAddresses.h"
+#include "lisa-deskbridge/Transport.h"
+#include "lisa-deskbridge/log.h"
+#include "lisa-deskbridge/bridges/SQMidi.h"
+#include "lisa-deskbridge/bridges/SQMitm.h"
+
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscReceivedElements.h"
+
+using namespace LisaDeskbridge;
+
+struct Result {
+    std::string name;
+    unsigned int iterations;
+    double nsPerOp;
+};
+
+static std::vector<Result> results;
+
+static void bench(const std::string & name, unsigned int iterations, std::function<void(unsigned int)> op){
+
+    // warm up
+    for(unsigned int i = 0; i < iterations / 10 + 1; i++){
+        op(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(unsigned int i = 0; i < iterations; i++){
+        op(i);
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    results.push_back({name, iterations, (double)duration.count() / (double)iterations});
+}
+
+// varying values, such that the value cache does not suppress anything
+static float valueOf(unsigned int i){
+    return (float)(i % 1000) / 1000.0f;
+}
+
+static SourceId_t sourceOf(unsigned int i){
+    return 1 + i % 96;
+}
+
+static void benchEncode(unsigned int iterations, NullTransport & transport, LisaControllerProxy::TxStats & stats){
+    LisaControllerProxy::Delegate delegate;
+    LisaControllerProxy proxy(&delegate);
+
+    proxy.getValueCache().setEnabled(false);
+    proxy.setRelativeFlushRate(0);
+    proxy.startDetached(transport);
+
+    bench("encode/setSourcePan", iterations, [&](unsigned int i){
+        proxy.setSourcePan(sourceOf(i), valueOf(i));
+    });
+    bench("encode/setSourceAllParameters", iterations, [&](unsigned int i){
+        float v = valueOf(i);
+        proxy.setSourceAllParameters(sourceOf(i), v, v, v, v, v);
+    });
+    bench("encode/setMasterFaderPos", iterations, [&](unsigned int i){
+        proxy.setMasterFaderPos(valueOf(i));
+    });
+    bench("encode/setSelectedSourcesRelativePan", iterations, [&](unsigned int i){
+        proxy.setSelectedSourcesRelativePan(valueOf(i) - 0.5f);
+    });
+    bench("encode/selectSource", iterations, [&](unsigned int i){
+        proxy.selectSource(sourceOf(i));
+    });
+    bench("encode/bundle16xSetSourcePan", iterations / 16 + 1, [&](unsigned int i){
+        LisaControllerProxy::BundleScope bundle(proxy);
+        for(unsigned int j = 0; j < 16; j++){
+            proxy.setSourcePan(sourceOf(i + j), valueOf(i));
+        }
+    });
+
+    proxy.stop();
+
+    stats = proxy.getTxStats();
+}
+
+static void benchDecode(unsigned int iterations){
+    LisaControllerProxy::Delegate delegate;
+    LisaControllerProxy proxy(&delegate);
+
+    IpEndpointName endpoint;
+
+    const char * fixed[] = {kMsgRxMasterGain, kMsgRxMasterFaderPos, kMsgRxReverbGain, kMsgRxReverbFaderPos};
+    const char * sourceParams[] = {kMsgRxSourcePan, kMsgRxSourceWidth, kMsgRxSourceDistance, kMsgRxSourceElevation, kMsgRxSourceAuxSend};
+
+    // packets as sent by L-ISA Controller (for source parameters: one per source)
+    auto encode = [](const char * address, std::vector<std::string> & packets){
+        char buffer[OUTPUT_BUFFER_SIZE];
+        osc::OutboundPacketStream stream(buffer, sizeof(buffer));
+        stream << osc::BeginMessage(address) << 0.5f << osc::EndMessage;
+        packets.push_back(std::string(stream.Data(), stream.Size()));
+    };
+
+    auto decode = [&](const std::string & name, const std::vector<std::string> & packets){
+        bench(name, iterations, [&](unsigned int i){
+            const std::string & packet = packets[i % packets.size()];
+            osc::ReceivedPacket p(packet.data(), (osc::osc_bundle_element_size_t)packet.size());
+            osc::ReceivedMessage m(p);
+            proxy.ProcessMessage(m, endpoint);
+        });
+    };
+
+    for(const char * address : fixed){
+        std::vector<std::string> packets;
+        encode(address, packets);
+        decode(std::string("decode/") + address, packets);
+    }
+
+    for(const char * format : sourceParams){
+        // "/ext/src/%u/p%n" -> "/ext/src/%u/p"
+        std::string pattern = format;
+        pattern.erase(pattern.find("%n"), 2);
+
+        std::vector<std::string> packets;
+        for(SourceId_t src = 1; src <= 96; src++){
+            std::string address = pattern;
+            address.replace(address.find("%u"), 2, std::to_string(src));
+            encode(address.data(), packets);
+        }
+
+        std::string name = "decode" + pattern;
+        name.replace(name.find("%u"), 2, "N");
+        decode(name, packets);
+    }
+}
+
+// as formerly done by LisaControllerProxy::ProcessMessage()
+static RxAddress parseRxAddressLegacy(const char * address){
+    SourceId_t src = 0;
+    int  n = 0;
+
+    if( std::strcmp( address, kMsgRxMasterGain ) == 0 ){
+        return {RxAddressMasterGain, 0};
+    }
+    else if( std::strcmp( address, kMsgRxMasterFaderPos ) == 0 ){
+        return {RxAddressMasterFaderPos, 0};
+    }
+    else if( std::strcmp( address, kMsgRxReverbGain ) == 0 ){
+        return {RxAddressReverbGain, 0};
+    }
+    else if( std::strcmp( address, kMsgRxReverbFaderPos ) == 0 ){
+        return {RxAddressReverbFaderPos, 0};
+    }
+    else if (sscanf(address, kMsgRxSourcePan, &src, &n) == 1 && n > 0){
+        return {RxAddressSourcePan, src};
+    }
+    else if (sscanf(address, kMsgRxSourceWidth, &src, &n) == 1 && n > 0){
+        return {RxAddressSourceWidth, src};
+    }
+    else if (sscanf(address, kMsgRxSourceDistance, &src, &n) == 1 && n > 0){
+        return {RxAddressSourceDistance, src};
+    }
+    else if (sscanf(address, kMsgRxSourceElevation, &src, &n) == 1 && n > 0){
+        return {RxAddressSourceElevation, src};
+    }
+    else if (sscanf(address, kMsgRxSourceAuxSend, &src, &n) == 1 && n > 0){
+        return {RxAddressSourceAuxSend, src};
+    }
+    return {RxAddressUnknown, 0};
+}
+
+// a feedback burst as sent by L-ISA Controller (plus a few addresses we do not handle)
+static bool benchParse(unsigned int iterations, unsigned int & checksum){
+    std::vector<std::string> addresses;
+
+    for(unsigned int src = 1; src <= 96; src++){
+        for(char param : {'p', 'w', 'd', 'e', 's'}){
+            addresses.push_back("/ext/src/" + std::to_string(src) + "/" + param);
+        }
+    }
+
+    addresses.push_back(kMsgRxMasterGain);
+    addresses.push_back(kMsgRxMasterFaderPos);
+    addresses.push_back(kMsgRxReverbGain);
+    addresses.push_back(kMsgRxReverbFaderPos);
+
+    addresses.push_back("/ext/monitor/gain");
+    addresses.push_back("/ext/snapshot/current");
+    addresses.push_back("/ext/src/1/x");
+
+    for(const std::string & address : addresses){
+        RxAddress a = parseRxAddress(address.data());
+        RxAddress b = parseRxAddressLegacy(address.data());
+        if (a.type != b.type || (a.type != RxAddressUnknown && a.id != b.id)){
+            fprintf(stderr, "Parsers disagree on %s\n", address.data());
+            return false;
+        }
+    }
+
+    bench("parse/strcmpSscanf", iterations, [&](unsigned int i){
+        RxAddress parsed = parseRxAddressLegacy(addresses[i % addresses.size()].data());
+        checksum += parsed.type + parsed.id;
+    });
+    bench("parse/singlePass", iterations, [&](unsigned int i){
+        RxAddress parsed = parseRxAddress(addresses[i % addresses.size()].data());
+        checksum += parsed.type + parsed.id;
+    });
+
+    return true;
+}
+
+class DecodeDelegate : public MidiReceiver::Delegate {
+    public:
+        unsigned int received = 0;
+
+        void decode(const libremidi::message & message){
+            receivedMessage(message);
+        }
+
+        void receivedNoteOn(int channel, int note, int velocity){ received++; }
+        void receivedNoteOff(int channel, int note, int velocity){ received++; }
+        void receivedControlChange(int channel, int cc, int value){ received++; }
+        void receivedPitchBend(int channel, int bend){ received++; }
+};
+
+static void benchMidiDecode(unsigned int iterations){
+    DecodeDelegate delegate;
+
+    struct {
+        const char * name;
+        std::vector<unsigned char> bytes;
+    } messages[] = {
+        {"midi/noteOn", {0x90, 60, 100}},
+        {"midi/controlChange", {0xB0, 1, 65}},
+        {"midi/pitchBend", {0xE0, 0x00, 0x40}},
+    };
+
+    for(auto & m : messages){
+        libremidi::message message;
+        message.bytes = m.bytes;
+        bench(m.name, iterations, [&](unsigned int i){
+            delegate.decode(message);
+        });
+    }
+}
+
+// gives access to the SQ MIDI Control delegate, which otherwise only a MIDI port can talk to
+class BenchSQMidi : public Bridges::SQMidi {
+    public:
+        BenchSQMidi(BridgeOpts & opts) : SQMidi(opts){}
+
+        void controlChange(int channel, int cc, int value){
+            sqMidiControlDelegate.receivedControlChange(channel, cc, value);
+        }
+};
+
+static void benchSQMidi(unsigned int iterations){
+    Bridge::BridgeOpts opts;
+    NullTransport transport;
+
+    try {
+        BenchSQMidi sq(opts);
+
+        sq.startDetached(transport);
+
+        bench("map/SQMidi/relativePan", iterations, [&](unsigned int i){
+            sq.controlChange(1, 1, (i & 1) ? 1 : 127);
+        });
+        bench("map/SQMidi/masterFader", iterations, [&](unsigned int i){
+            sq.controlChange(2, 0, i % 128);
+        });
+
+        sq.stop();
+    } catch (const std::exception & e){
+        // constructing the bridge requires a MIDI backend
+        fprintf(stderr, "Skipping SQ-Midi: %s\n", e.what());
+    }
+}
+
+static void benchSQMitm(unsigned int iterations){
+    Bridge::BridgeOpts opts;
+    opts["mixer-ip"] = "127.0.0.1";
+    NullTransport transport;
+
+    try {
+        Bridges::SQMitm sq(opts);
+
+        sq.startDetached(transport);
+
+        bench("map/SQMitm/onSelectedChannel", iterations, [&](unsigned int i){
+            sq.onSelectedChannel(i % 40);
+        });
+        bench("map/SQMitm/onMidiControlChange", iterations, [&](unsigned int i){
+            sq.onMidiControlChange(1, 1, (i & 1) ? 1 : 127);
+        });
+        bench("map/SQMitm/onMidiFaderLevel", iterations, [&](unsigned int i){
+            sq.onMidiFaderLevel(0, i % 256);
+        });
+
+        sq.stop();
+    } catch (const std::exception & e){
+        fprintf(stderr, "Skipping SQ-Mitm: %s\n", e.what());
+    }
+}
+
+int main(int argc, char * argv[]){
+
+    unsigned int iterations = 100000;
+
+    if (argc > 1){
+        iterations = atoi(argv[1]);
+        if (iterations == 0){
+            fprintf(stderr, "Usage: %s [<iterations>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // stdout is for the results only
+    setLogFile(stderr);
+    setLogLevel(LogLevelError);
+
+    NullTransport transport;
+    LisaControllerProxy::TxStats stats;
+
+    benchEncode(iterations, transport, stats);
+    benchDecode(iterations);
+
+    // keeps the parsed results alive
+    unsigned int checksum = 0;
+    if (!benchParse(iterations, checksum)){
+        return EXIT_FAILURE;
+    }
+
+    benchMidiDecode(iterations);
+    benchSQMidi(iterations);
+    benchSQMitm(iterations);
+
+    fprintf(stdout, "{\n");
+    fprintf(stdout, "  \"iterations\": %u,\n", iterations);
+    fprintf(stdout, "  \"encode_tx\": {\"pushed\": %llu, \"dropped\": %llu, \"sent\": %llu, \"syscalls\": %llu, \"bytes\": %llu},\n",
+        (unsigned long long)stats.pushed, (unsigned long long)stats.dropped, (unsigned long long)stats.sent,
+        (unsigned long long)stats.syscalls, (unsigned long long)transport.getBytes());
+    fprintf(stdout, "  \"parse_checksum\": %u,\n", checksum);
+    fprintf(stdout, "  \"benchmarks\": [\n");
+    for(size_t i = 0; i < results.size(); i++){
+        fprintf(stdout, "    {\"name\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f}%s\n",
+            results[i].name.data(), results[i].iterations, results[i].nsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(stdout, "  ]\n");
+    fprintf(stdout, "}\n");
+
+    return EXIT_SUCCESS;
+}
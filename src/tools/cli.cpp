@@ -25,6 +25,8 @@
 #include "sqmixmitm/log.h"
 
 #include "lisa-deskbridge/Bridge.h"
+#include "lisa-deskbridge/Capture.h"
+#include "lisa-deskbridge/PeriodicTask.h"
 #include "lisa-deskbridge/bridges/Generic.h"
 #include "lisa-deskbridge/bridges/SQMidi.h"
 #include "lisa-deskbridge/bridges/SQMitm.h"
@@ -35,6 +37,9 @@ LisaDeskbridge::Bridge * bridge;
 
 static struct {
     int logLevel;
+    bool asyncLog;
+    unsigned int statsInterval;
+    const char * captureFile;
     std::string bridgeName;
     LisaDeskbridge::Bridge::BridgeOpts bridgeOpts;
     unsigned short localPort;
@@ -42,6 +47,9 @@ static struct {
     unsigned short lisaPort;
 } opts = {
     .logLevel = LisaDeskbridge::LogLevelInfo,
+    .asyncLog = false,
+    .statsInterval = 0,
+    .captureFile = nullptr,
     .bridgeName = "",
     .localPort = LisaDeskbridge::kDevicePortDefault,
     .lisaHost = "127.0.0.1",
@@ -59,6 +67,9 @@ static void help(){
         "\nOptions:\n"
         "\t -h, -?                  Show this help\n"
         "\t -v<verbosity>           Verbose output (in 0 (none), 1 (error), 2 (info = default), 3 (debug)\n"
+        "\t --async-log             Write log messages from a background thread (messages are dropped if it can not keep up)\n"
+        "\t --stats-interval <s>    Periodically log TX counters and latencies (also logged on SIGUSR1)\n"
+        "\t --capture <file>        Record MIDI input, mixer events and OSC traffic (for lisa-deskbridge-replay)\n"
         "\t --lisa-ip               L-ISA Controller ip (default: %s)\n"
         "\t --lisa-port             L-ISA Controller port (default: %hu)\n"
         "\t --device-ip             Own OSC target IP as will be registered with L-ISA Controller (default: 127.0.0.1)\n"
@@ -106,6 +117,9 @@ int main(int argc, char * argv[]) {
                 {"device-id",required_argument,0,5},
                 {"device-name",required_argument,0,6},
                 {"claim-level-control",required_argument,0,7},
+                {"async-log",no_argument,0,8},
+                {"stats-interval",required_argument,0,9},
+                {"capture",required_argument,0,10},
                 {"bridge-opt", required_argument,0,'o'},
                 {0,0,0,0}
         };
@@ -148,6 +162,22 @@ int main(int argc, char * argv[]) {
                 opts.bridgeOpts["claim-level-control"] = optarg;
                 break;
 
+            case 8: // --async-log
+                opts.asyncLog = true;
+                break;
+
+            case 9: // --stats-interval
+                if (std::atoi(optarg) <= 0){
+                    std::cout << "Invalid stats interval: " << optarg << std::endl;
+                    return EXIT_FAILURE;
+                }
+                opts.statsInterval = std::atoi(optarg);
+                break;
+
+            case 10: // --capture
+                opts.captureFile = optarg;
+                break;
+
             case 'o': // bridge specific options
                 arg = optarg;
                 pos = arg.find_first_of('=');
@@ -185,10 +215,18 @@ int main(int argc, char * argv[]) {
     // setup logging components
     LisaDeskbridge::setLogLevel((LisaDeskbridge::LogLevel)opts.logLevel);
 
+    if (opts.asyncLog){
+        LisaDeskbridge::startAsyncLog();
+    }
+
     SQMixMitm::setLogLevel((SQMixMitm::LogLevel)opts.logLevel);
     SQMixMitm::setLogFunction((SQMixMitm::LogFunction)LisaDeskbridge::log);
 
 
+    if (opts.captureFile != nullptr && LisaDeskbridge::startCapture(opts.captureFile) == false){
+        return EXIT_FAILURE;
+    }
+
     opts.bridgeName = argv[optind];
 
     bridge = LisaDeskbridge::Bridge::factory(opts.bridgeName, opts.bridgeOpts);
@@ -196,16 +234,29 @@ int main(int argc, char * argv[]) {
         std::cout << "Invalid bridge: " << opts.bridgeName << std::endl;
         return EXIT_FAILURE;
     }
-    LisaDeskbridge::log(LisaDeskbridge::LogLevelInfo, "Using bridge: %s", opts.bridgeName.data());
+    LISA_LOG_INFO("Using bridge: %s", opts.bridgeName.data());
 
     if (bridge->start() == false){
         return EXIT_FAILURE;
     }
 
+    LisaDeskbridge::PeriodicTask statsTask;
+    if (opts.statsInterval > 0){
+        statsTask.start(std::chrono::seconds(opts.statsInterval), [](){
+            bridge->logStats(true);
+        });
+    }
+
     // This will run in a process loop until done
     bridge->runloop();
 
+    statsTask.stop();
+
     bridge->stop();
 
+    LisaDeskbridge::stopCapture();
+
+    LisaDeskbridge::stopAsyncLog();
+
     return EXIT_SUCCESS;
 }
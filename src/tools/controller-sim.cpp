@@ -0,0 +1,832 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+ * Loopback L-ISA Controller simulator, for testing throughput and latency without an actual controller.
+ *
+ * Understands all messages of LisaController.h, keeps the state they imply and sends source parameter and
+ * fader feedback (kMsgRx*) to registered devices (with sending enabled): as reaction to changes (--echo)
+ * and/or periodically at configurable rates (feedback floods). Pings are answered.
+ * Arrival times of all received messages can be recorded.
+ */
+
+#include <getopt.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "lisa-deskbridge/LisaController.h"
+#include "lisa-deskbridge/Latency.h"
+#include "lisa-deskbridge/OscAddresses.h"
+#include "lisa-deskbridge/PeriodicTask.h"
+#include "lisa-deskbridge/log.h"
+
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscPacketListener.h"
+#include "osc/OscReceivedElements.h"
+#include "ip/UdpSocket.h"
+
+using namespace LisaDeskbridge;
+
+static char * argv0 = nullptr;
+
+static struct {
+    int logLevel;
+    unsigned short port;
+    bool echo;
+    unsigned int sources;
+    unsigned int sourceRate;
+    unsigned int faderRate;
+    unsigned int statsInterval;
+    const char * arrivalsFile;
+} opts = {
+    .logLevel = LogLevelInfo,
+    .port = kLisaControllerPortDefault,
+    .echo = false,
+    .sources = 96,
+    .sourceRate = 0,
+    .faderRate = 0,
+    .statsInterval = 1,
+    .arrivalsFile = nullptr
+};
+
+/**
+ * Sequential access to the arguments of a message, ints and floats are converted as needed.
+ */
+class Args {
+    protected:
+        osc::ReceivedMessage::const_iterator it;
+        osc::ReceivedMessage::const_iterator end;
+
+        osc::ReceivedMessageArgument next(){
+            if (it == end){
+                throw osc::MissingArgumentException();
+            }
+            osc::ReceivedMessageArgument arg = *it;
+            ++it;
+            return arg;
+        }
+
+    public:
+        Args(const osc::ReceivedMessage & m) : it(m.ArgumentsBegin()), end(m.ArgumentsEnd()){}
+
+        float f(){
+            osc::ReceivedMessageArgument arg = next();
+            return arg.IsInt32() ? (float)arg.AsInt32() : arg.AsFloat();
+        }
+        int i(){
+            osc::ReceivedMessageArgument arg = next();
+            return arg.IsFloat() ? (int)arg.AsFloat() : arg.AsInt32();
+        }
+        const char * s(){
+            return next().AsString();
+        }
+};
+
+class ControllerSim : public osc::OscPacketListener {
+
+    public:
+
+        // source parameters, as far as there are kMsgRx* counterparts in the same order as RxAddressSource*
+        enum Param_t { ParamPan, ParamWidth, ParamDistance, ParamElevation, ParamAuxSend, ParamPanSpread, ParamCount };
+
+        static constexpr unsigned int kFlagCount = 5;
+        static constexpr unsigned int kOptCount = 7;
+
+        struct Source {
+            float param[ParamCount];
+            std::string flag[kFlagCount];
+            bool solo;
+            float delayMs;
+            bool opt[kOptCount];
+            std::string delayMode;
+            float fxIntensity[OscAddressTable::kMaxFxId + 1];
+            bool fxActive[OscAddressTable::kMaxFxId + 1];
+            bool selected;
+        };
+
+        struct Group {
+            float param[ParamCount];
+        };
+
+        struct Fader {
+            float gain;
+            float pos;
+            bool mute;
+        };
+
+        struct Device {
+            bool registered;
+            std::string ip;
+            int port;
+            IpEndpointName endpoint;
+            std::string name;
+            bool send;
+            bool receive;
+            std::string format;
+            bool masterGainControl;
+        };
+
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> unknown{0};
+        std::atomic<uint64_t> invalid{0};
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> receivedByClass[MessageClassCount] = {};
+
+    protected:
+
+        UdpListeningReceiveSocket * socket = nullptr;
+        std::mutex sendMutex;
+
+        FILE * arrivals = nullptr;
+        uint64_t startTime = 0;
+
+        // NOTE all state is guarded by stateMutex (changed by the RX thread and the feedback tasks)
+        std::mutex stateMutex;
+
+        Source sources[OscAddressTable::kMaxSourceId + 1];
+        Group groups[OscAddressTable::kMaxGroupId + 1];
+        Fader master, reverb, monitor;
+        Fader userFaders[OscAddressTable::kMaxUserFader + 1];
+        Device devices[OscAddressTable::kMaxDeviceId + 1];
+        GroupId_t selectedGroup = 0;
+        SnapshotId_t currentSnapshot = 1;
+        SnapshotId_t snapshotCount = 1;
+        ReverbId_t reverbPreset = 0;
+        bool fxRunning[OscAddressTable::kMaxFxId + 1];
+        bool bpmSync = false;
+        float bpm = 120.0f;
+        std::string headtrackerType = kHeadtrackerTypeOff;
+        float headtracker[3] = {0.0f, 0.0f, 0.0f};
+
+        float phase = 0.0f;
+
+        typedef void (*Handler)(ControllerSim & sim, const unsigned int * id, Args & args);
+
+        struct Route {
+            const char * format;
+            Handler handler;
+        };
+
+        static const Route kRoutes[];
+
+        /**
+         * Matches address against a kMsg* format, where %u and %d take a number (stored in ids).
+         */
+        static bool match(const char * format, const char * address, unsigned int * ids){
+            int n = 0;
+            while(*format != '\0'){
+                if (format[0] == '%' && (format[1] == 'u' || format[1] == 'd')){
+                    if (*address < '0' || '9' < *address){
+                        return false;
+                    }
+                    unsigned int id = 0;
+                    while('0' <= *address && *address <= '9'){
+                        id = id * 10 + (*address - '0');
+                        address++;
+                    }
+                    ids[n++] = id;
+                    format += 2;
+                } else if (*format++ != *address++){
+                    return false;
+                }
+            }
+            return *address == '\0';
+        }
+
+        static float clamp(float value, float min, float max){
+            return value < min ? min : (max < value ? max : value);
+        }
+
+        static void checkSource(SourceId_t src){
+            if (!isValidSourceId(src)){
+                throw osc::Exception("invalid source id");
+            }
+        }
+
+        void send(const char * address, float value){
+            // address, type tags and a float
+            char buffer[OscAddress::kCapacity + 16];
+            osc::OutboundPacketStream stream(buffer, sizeof(buffer));
+            stream << osc::BeginMessage(address) << value << osc::EndMessage;
+
+            std::lock_guard<std::mutex> lock(sendMutex);
+
+            for(DeviceId_t d = 1; d <= OscAddressTable::kMaxDeviceId; d++){
+                if (devices[d].registered && devices[d].send){
+                    socket->SendTo(devices[d].endpoint, stream.Data(), stream.Size());
+                    sent.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void feedbackSource(SourceId_t src, Param_t param){
+            if (param == ParamPanSpread){
+                return; // no feedback
+            }
+            static const SourceAddress_t addresses[] = {SourceAddressPan, SourceAddressWidth, SourceAddressDistance, SourceAddressElevation, SourceAddressAuxSend};
+            send(OscAddressTable::instance().source(src, addresses[param]).str, sources[src].param[param]);
+        }
+
+        void feedbackFader(const char * gainAddress, const char * posAddress, Fader & fader){
+            send(gainAddress, fader.gain);
+            send(posAddress, fader.pos);
+        }
+
+    public:
+
+        ControllerSim(){
+            for(SourceId_t src = 0; src <= OscAddressTable::kMaxSourceId; src++){
+                Source & s = sources[src];
+                for(float & p : s.param){
+                    p = 0.5f;
+                }
+                for(std::string & f : s.flag){
+                    f = kControlFlagSnap;
+                }
+                s.solo = false;
+                s.delayMs = 0.0f;
+                for(bool & o : s.opt){
+                    o = true;
+                }
+                s.delayMode = kDelayModeStatic;
+                for(unsigned int fx = 0; fx <= OscAddressTable::kMaxFxId; fx++){
+                    s.fxIntensity[fx] = 0.0f;
+                    s.fxActive[fx] = false;
+                }
+                s.selected = false;
+            }
+            for(GroupId_t grp = 0; grp <= OscAddressTable::kMaxGroupId; grp++){
+                for(float & p : groups[grp].param){
+                    p = 0.0f;
+                }
+            }
+            master = reverb = monitor = {0.75f, 0.75f, false};
+            for(Fader & f : userFaders){
+                f = {0.75f, 0.75f, false};
+            }
+            for(Device & d : devices){
+                d.registered = false;
+                d.port = 0;
+                d.send = false;
+                d.receive = true;
+                d.format = kCoordFormatLISA;
+                d.masterGainControl = false;
+            }
+            for(bool & fx : fxRunning){
+                fx = false;
+            }
+        }
+
+        void start(unsigned short port, FILE * arrivals){
+            this->arrivals = arrivals;
+            startTime = latencyNow();
+
+            socket = new UdpListeningReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, port), this);
+        }
+
+        void run(){
+            socket->RunUntilSigInt();
+        }
+
+        void stop(){
+            delete socket;
+            socket = nullptr;
+        }
+
+        virtual void ProcessMessage(const osc::ReceivedMessage & m, const IpEndpointName & /*remoteEndpoint*/){
+            const char * address = m.AddressPattern();
+
+            if (arrivals != nullptr){
+                fprintf(arrivals, "%llu %s\n", (unsigned long long)(latencyNow() - startTime), address);
+            }
+
+            received.fetch_add(1, std::memory_order_relaxed);
+            receivedByClass[classifyAddress(address)].fetch_add(1, std::memory_order_relaxed);
+
+            unsigned int ids[2] = {0, 0};
+
+            for(const Route * route = kRoutes; route->format != nullptr; route++){
+                if (match(route->format, address, ids)){
+                    try {
+                        Args args(m);
+                        std::lock_guard<std::mutex> lock(stateMutex);
+                        route->handler(*this, ids, args);
+                    } catch (osc::Exception & e){
+                        invalid.fetch_add(1, std::memory_order_relaxed);
+                        LISA_LOG_DEBUG("Invalid message %s: %s", address, e.what());
+                    }
+                    return;
+                }
+            }
+
+            unknown.fetch_add(1, std::memory_order_relaxed);
+            LISA_LOG_INFO("Unknown message: %s", address);
+        }
+
+        // Handlers (called with stateMutex held)
+
+        void setSource(SourceId_t src, Param_t param, float value){
+            checkSource(src);
+            sources[src].param[param] = clamp(value, 0.0f, 1.0f);
+            if (opts.echo){
+                feedbackSource(src, param);
+            }
+        }
+
+        void changeSource(SourceId_t src, Param_t param, float delta){
+            checkSource(src);
+            setSource(src, param, sources[src].param[param] + delta);
+        }
+
+        void changeSelectedSources(Param_t param, float delta){
+            for(SourceId_t src = 1; src <= OscAddressTable::kMaxSourceId; src++){
+                if (sources[src].selected){
+                    changeSource(src, param, delta);
+                }
+            }
+        }
+
+        void setSourceFlag(SourceId_t src, unsigned int flag, const char * value){
+            checkSource(src);
+            sources[src].flag[flag] = value;
+        }
+
+        void setAllSourcesFlag(unsigned int flag, const char * value){
+            for(SourceId_t src = 1; src <= OscAddressTable::kMaxSourceId; src++){
+                sources[src].flag[flag] = value;
+            }
+        }
+
+        void setSourceOpt(SourceId_t src, unsigned int opt, int on){
+            checkSource(src);
+            sources[src].opt[opt] = (on != 0);
+        }
+
+        Group & group(GroupId_t grp){
+            if (!isValidGroupId(grp)){
+                throw osc::Exception("invalid group id");
+            }
+            return groups[grp];
+        }
+
+        void setGroup(GroupId_t grp, Param_t param, float value){
+            group(grp).param[param] = clamp(value, -1.0f, 1.0f);
+        }
+
+        void changeGroup(GroupId_t grp, Param_t param, float delta){
+            setGroup(grp, param, group(grp).param[param] + delta);
+        }
+
+        Device & device(DeviceId_t id){
+            if (!isValidDeviceId(id)){
+                throw osc::Exception("invalid device id");
+            }
+            return devices[id];
+        }
+
+        void registerDevice(DeviceId_t id, const char * ip, int port){
+            std::lock_guard<std::mutex> lock(sendMutex);
+            Device & d = device(id);
+            d.registered = true;
+            d.ip = ip;
+            d.port = port;
+            d.endpoint = IpEndpointName(ip, port);
+            LISA_LOG_INFO("Registered device %u at %s:%d", id, ip, port);
+        }
+
+        void pong(const char * ip, int port){
+            char buffer[OscAddress::kCapacity];
+            osc::OutboundPacketStream stream(buffer, sizeof(buffer));
+            stream << osc::BeginMessage(kMsgRxPong) << osc::EndMessage;
+
+            std::lock_guard<std::mutex> lock(sendMutex);
+            socket->SendTo(IpEndpointName(ip, port), stream.Data(), stream.Size());
+            sent.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void deleteDevice(DeviceId_t id){
+            std::lock_guard<std::mutex> lock(sendMutex);
+            device(id).registered = false;
+            LISA_LOG_INFO("Deleted device %u", id);
+        }
+
+        void enableSending(DeviceId_t id, int on){
+            std::lock_guard<std::mutex> lock(sendMutex);
+            device(id).send = (on != 0);
+            LISA_LOG_INFO("Sending to device %u: %s", id, on ? "on" : "off");
+        }
+
+        Fader & userFader(unsigned int fader){
+            if (fader < 1 || OscAddressTable::kMaxUserFader < fader){
+                throw osc::Exception("invalid user fader");
+            }
+            return userFaders[fader];
+        }
+
+        void setMaster(float gain, float pos){
+            master.gain = clamp(gain, 0.0f, 1.0f);
+            master.pos = clamp(pos, 0.0f, 1.0f);
+            if (opts.echo){
+                feedbackFader(kMsgRxMasterGain, kMsgRxMasterFaderPos, master);
+            }
+        }
+
+        void setReverb(float gain, float pos){
+            reverb.gain = clamp(gain, 0.0f, 1.0f);
+            reverb.pos = clamp(pos, 0.0f, 1.0f);
+            if (opts.echo){
+                feedbackFader(kMsgRxReverbGain, kMsgRxReverbFaderPos, reverb);
+            }
+        }
+
+        void select(SourceId_t src, bool exclusive, bool toggle){
+            checkSource(src);
+            if (exclusive){
+                clearSelection();
+            }
+            sources[src].selected = toggle ? !sources[src].selected : true;
+        }
+
+        void clearSelection(){
+            for(Source & s : sources){
+                s.selected = false;
+            }
+            selectedGroup = 0;
+        }
+
+        void fireSnapshot(SnapshotId_t snapshot){
+            if (!isValidSnapshotId(snapshot) || snapshotCount < snapshot){
+                throw osc::Exception("invalid snapshot");
+            }
+            currentSnapshot = snapshot;
+        }
+
+        void fx(FxId_t fx, bool running){
+            if (!isValidFxId(fx)){
+                throw osc::Exception("invalid fx id");
+            }
+            fxRunning[fx] = running;
+        }
+
+        // Feedback floods
+
+        void floodSources(){
+            std::lock_guard<std::mutex> lock(stateMutex);
+
+            phase += 0.01f;
+
+            for(SourceId_t src = 1; src <= opts.sources; src++){
+                for(int p = ParamPan; p <= ParamAuxSend; p++){
+                    sources[src].param[p] = 0.5f + 0.5f * std::sin(phase + (float)(src * ParamCount + p));
+                    feedbackSource(src, (Param_t)p);
+                }
+            }
+        }
+
+        void floodFaders(){
+            std::lock_guard<std::mutex> lock(stateMutex);
+
+            float v = 0.5f + 0.5f * std::sin(phase * 3.0f);
+
+            master.gain = master.pos = v;
+            reverb.gain = reverb.pos = 1.0f - v;
+
+            feedbackFader(kMsgRxMasterGain, kMsgRxMasterFaderPos, master);
+            feedbackFader(kMsgRxReverbGain, kMsgRxReverbFaderPos, reverb);
+        }
+};
+
+#define SIM [](ControllerSim & sim [[maybe_unused]], const unsigned int * id [[maybe_unused]], Args & args [[maybe_unused]])
+
+// in the order of LisaController.h (addresses must match completely, so order does not matter)
+const ControllerSim::Route ControllerSim::kRoutes[] = {
+    // Source control flags
+    {kMsgSetSourceControlPan,           SIM { sim.setSourceFlag(id[0], 0, args.s()); }},
+    {kMsgSetSourceControlWidth,         SIM { sim.setSourceFlag(id[0], 1, args.s()); }},
+    {kMsgSetSourceControlDistance,      SIM { sim.setSourceFlag(id[0], 2, args.s()); }},
+    {kMsgSetSourceControlElevation,     SIM { sim.setSourceFlag(id[0], 3, args.s()); }},
+    {kMsgSetSourceControlAuxSend,       SIM { sim.setSourceFlag(id[0], 4, args.s()); }},
+    {kMsgSetAllSourcesControlPan,       SIM { sim.setAllSourcesFlag(0, args.s()); }},
+    {kMsgSetAllSourcesControlWidth,     SIM { sim.setAllSourcesFlag(1, args.s()); }},
+    {kMsgSetAllSourcesControlDistance,  SIM { sim.setAllSourcesFlag(2, args.s()); }},
+    {kMsgSetAllSourcesControlElevation, SIM { sim.setAllSourcesFlag(3, args.s()); }},
+    {kMsgSetAllSourcesControlAuxSend,   SIM { sim.setAllSourcesFlag(4, args.s()); }},
+
+    // Source parameters
+    {kMsgSetSourcePan,                  SIM { sim.setSource(id[0], ControllerSim::ParamPan, args.f()); }},
+    {kMsgSetSourceWidth,                SIM { sim.setSource(id[0], ControllerSim::ParamWidth, args.f()); }},
+    {kMsgSetSourceDistance,             SIM { sim.setSource(id[0], ControllerSim::ParamDistance, args.f()); }},
+    {kMsgSetSourceElevation,            SIM { sim.setSource(id[0], ControllerSim::ParamElevation, args.f()); }},
+    {kMsgSetSourcePanSpread,            SIM { sim.setSource(id[0], ControllerSim::ParamPanSpread, args.f()); }},
+    {kMsgSetSourceAuxSend,              SIM { sim.setSource(id[0], ControllerSim::ParamAuxSend, args.f()); }},
+    {kMsgSetSourceAllParameters,        SIM {
+        float pan = args.f(), width = args.f(), distance = args.f(), elevation = args.f(), auxSend = args.f();
+        sim.setSource(id[0], ControllerSim::ParamPan, pan);
+        sim.setSource(id[0], ControllerSim::ParamWidth, width);
+        sim.setSource(id[0], ControllerSim::ParamDistance, distance);
+        sim.setSource(id[0], ControllerSim::ParamElevation, elevation);
+        sim.setSource(id[0], ControllerSim::ParamAuxSend, auxSend);
+    }},
+    {kMsgSetSourceRelativePan,          SIM { sim.changeSource(id[0], ControllerSim::ParamPan, args.f()); }},
+    {kMsgSetSourceRelativeWidth,        SIM { sim.changeSource(id[0], ControllerSim::ParamWidth, args.f()); }},
+    {kMsgSetSourceRelativeDistance,     SIM { sim.changeSource(id[0], ControllerSim::ParamDistance, args.f()); }},
+    {kMsgSetSourceRelativeElevation,    SIM { sim.changeSource(id[0], ControllerSim::ParamElevation, args.f()); }},
+    {kMsgSetSourceRelativePanSpread,    SIM { sim.changeSource(id[0], ControllerSim::ParamPanSpread, args.f()); }},
+    {kMsgSetSourceRelativeAuxSend,      SIM { sim.changeSource(id[0], ControllerSim::ParamAuxSend, args.f()); }},
+    {kMsgSetSourceFxIntensity,          SIM {
+        ControllerSim::checkSource(id[0]);
+        if (!isValidFxId(id[1])) throw osc::Exception("invalid fx id");
+        sim.sources[id[0]].fxIntensity[id[1]] = args.f();
+    }},
+    {kMsgSetSourceFxOn,                 SIM {
+        ControllerSim::checkSource(id[0]);
+        if (!isValidFxId(id[1])) throw osc::Exception("invalid fx id");
+        sim.sources[id[0]].fxActive[id[1]] = (args.i() != 0);
+    }},
+    {kMsgSetSelectedSourcesRelativePan,         SIM { sim.changeSelectedSources(ControllerSim::ParamPan, args.f()); }},
+    {kMsgSetSelectedSourcesRelativeWidth,       SIM { sim.changeSelectedSources(ControllerSim::ParamWidth, args.f()); }},
+    {kMsgSetSelectedSourcesRelativeDistance,    SIM { sim.changeSelectedSources(ControllerSim::ParamDistance, args.f()); }},
+    {kMsgSetSelectedSourcesRelativeElevation,   SIM { sim.changeSelectedSources(ControllerSim::ParamElevation, args.f()); }},
+    {kMsgSetSelectedSourcesRelativePanSpread,   SIM { sim.changeSelectedSources(ControllerSim::ParamPanSpread, args.f()); }},
+
+    // Source solo, snap, delay
+    {kMsgSetSourceSolo,                 SIM { ControllerSim::checkSource(id[0]); sim.sources[id[0]].solo = (args.i() != 0); }},
+    {kMsgSetSourceStaticDelayValue,     SIM { ControllerSim::checkSource(id[0]); sim.sources[id[0]].delayMs = args.f(); }},
+    {kMsgSnapSourceToSpeaker,           SIM { ControllerSim::checkSource(id[0]); }},
+
+    // Source processing
+    {kMsgSetSourceOptGain,              SIM { sim.setSourceOpt(id[0], 0, args.i()); }},
+    {kMsgSetSourceOptHpf,               SIM { sim.setSourceOpt(id[0], 1, args.i()); }},
+    {kMsgSetSourceOptDelayEnabled,      SIM { sim.setSourceOpt(id[0], 2, args.i()); }},
+    {kMsgSetSourceOptDelayMode,         SIM { ControllerSim::checkSource(id[0]); sim.sources[id[0]].delayMode = args.s(); }},
+    {kMsgSetSourceOptReverbEarly,       SIM { sim.setSourceOpt(id[0], 3, args.i()); }},
+    {kMsgSetSourceOptReverbCluster,     SIM { sim.setSourceOpt(id[0], 4, args.i()); }},
+    {kMsgSetSourceOptReverbLate,        SIM { sim.setSourceOpt(id[0], 5, args.i()); }},
+    {kMsgSetSourceOptDirectSound,       SIM { sim.setSourceOpt(id[0], 6, args.i()); }},
+
+    // Group parameters
+    {kMsgSetGroupPan,                   SIM { sim.setGroup(id[0], ControllerSim::ParamPan, args.f()); }},
+    {kMsgSetGroupWidth,                 SIM { sim.setGroup(id[0], ControllerSim::ParamWidth, args.f()); }},
+    {kMsgSetGroupDistance,              SIM { sim.setGroup(id[0], ControllerSim::ParamDistance, args.f()); }},
+    {kMsgSetGroupElevation,             SIM { sim.setGroup(id[0], ControllerSim::ParamElevation, args.f()); }},
+    {kMsgSetGroupAuxSend,               SIM { sim.setGroup(id[0], ControllerSim::ParamAuxSend, args.f()); }},
+    {kMsgSetGroupPanSpread,             SIM { sim.setGroup(id[0], ControllerSim::ParamPanSpread, args.f()); }},
+    {kMsgSetGroupRelativePan,           SIM { sim.changeGroup(id[0], ControllerSim::ParamPan, args.f()); }},
+    {kMsgSetGroupRelativeWidth,         SIM { sim.changeGroup(id[0], ControllerSim::ParamWidth, args.f()); }},
+    {kMsgSetGroupRelativeDistance,      SIM { sim.changeGroup(id[0], ControllerSim::ParamDistance, args.f()); }},
+    {kMsgSetGroupRelativeElevation,     SIM { sim.changeGroup(id[0], ControllerSim::ParamElevation, args.f()); }},
+    {kMsgSetGroupRelativeAuxSend,       SIM { sim.changeGroup(id[0], ControllerSim::ParamAuxSend, args.f()); }},
+    {kMsgSetGroupRelativePanSpread,     SIM { sim.changeGroup(id[0], ControllerSim::ParamPanSpread, args.f()); }},
+
+    // Snapshots
+    {kMsgFireSnapshot,                  SIM { sim.fireSnapshot(id[0]); }},
+    {kMsgFirePreviousSnapshot,          SIM { sim.fireSnapshot(sim.currentSnapshot > 1 ? sim.currentSnapshot - 1 : 1); }},
+    {kMsgFireNextSnapshot,              SIM { sim.fireSnapshot(sim.currentSnapshot < sim.snapshotCount ? sim.currentSnapshot + 1 : sim.snapshotCount); }},
+    {kMsgRefireCurrentSnapshot,         SIM { sim.fireSnapshot(sim.currentSnapshot); }},
+    {kMsgSaveCurrentSnapshot,           SIM { }},
+    {kMsgSaveAsNewSnapshot,             SIM { sim.currentSnapshot = ++sim.snapshotCount; }},
+
+    // Reverbs
+    {kMsgLoadReverbPreset,              SIM {
+        if (!isValidReverbId(id[0])) throw osc::Exception("invalid reverb id");
+        sim.reverbPreset = id[0];
+    }},
+
+    // FX
+    {kMsgStartFx,                       SIM { sim.fx(id[0], true); }},
+    {kMsgRestartFx,                     SIM { sim.fx(id[0], true); }},
+    {kMsgStopFx,                        SIM { sim.fx(id[0], false); }},
+
+    // BPM
+    {kMsgLockBpmToMidiClock,            SIM { sim.bpmSync = (args.i() != 0); }},
+    {kMsgSetBpm,                        SIM {
+        float bpm = args.f();
+        if (!isValidBpm(bpm)) throw osc::Exception("invalid bpm");
+        sim.bpm = bpm;
+    }},
+    {kMsgBpmTap,                        SIM { }},
+
+    // Faders
+    {kMsgSetMasterGain,                 SIM { sim.setMaster(args.f(), sim.master.pos); }},
+    {kMsgSetMasterFaderPos,             SIM { sim.setMaster(sim.master.gain, args.f()); }},
+    {kMsgSetMasterMute,                 SIM { sim.master.mute = (args.i() != 0); }},
+    {kMsgSetReverbGain,                 SIM { sim.setReverb(args.f(), sim.reverb.pos); }},
+    {kMsgSetReverbFaderPos,             SIM { sim.setReverb(sim.reverb.gain, args.f()); }},
+    {kMsgSetReverbMute,                 SIM { sim.reverb.mute = (args.i() != 0); }},
+    {kMsgSetMonitorGain,                SIM { sim.monitor.gain = args.f(); }},
+    {kMsgSetMonitorFaderPos,            SIM { sim.monitor.pos = args.f(); }},
+    {kMsgSetMonitorMute,                SIM { sim.monitor.mute = (args.i() != 0); }},
+    {kMsgSetUserFaderNGain,             SIM { sim.userFader(id[0]).gain = args.f(); }},
+    {kMsgSetUserFaderNPos,              SIM { sim.userFader(id[0]).pos = args.f(); }},
+    {kMsgSetUserFaderNMute,             SIM { sim.userFader(id[0]).mute = (args.i() != 0); }},
+
+    // Selection
+    {kMsgChangeSelectionOfSource,       SIM { sim.select(id[0], false, true); }},
+    {kMsgSetSelectionToSource,          SIM { sim.select(id[0], true, false); }},
+    {kMsgClearSelection,                SIM { sim.clearSelection(); }},
+    {kMsgSetSelectionToGroup,           SIM { sim.group(id[0]); sim.clearSelection(); sim.selectedGroup = id[0]; }},
+
+    // Headtracker
+    {kMsgSetHeadtrackerOrientation,     SIM { sim.headtracker[0] = args.f(); sim.headtracker[1] = args.f(); sim.headtracker[2] = args.f(); }},
+    {kMsgResetHeadtracker,              SIM { sim.headtracker[0] = sim.headtracker[1] = sim.headtracker[2] = 0.0f; }},
+    {kMsgSetHeadtrackerType,            SIM { sim.headtrackerType = args.s(); }},
+
+    // Devices
+    {kMsgRegisterDevice,                SIM { const char * ip = args.s(); sim.registerDevice(id[0], ip, args.i()); }},
+    {kMsgDeleteDevice,                  SIM { sim.deleteDevice(id[0]); }},
+    {kMsgSetDeviceName,                 SIM { sim.device(id[0]).name = args.s(); }},
+    {kMsgEnableSendingToDevice,         SIM { sim.enableSending(id[0], args.i()); }},
+    {kMsgEnableReceivingFromDevice,     SIM { sim.device(id[0]).receive = (args.i() != 0); }},
+    {kMsgSetDeviceCoordFormat,          SIM { sim.device(id[0]).format = args.s(); }},
+    {kMsgSetMasterGainControl,          SIM { sim.device(id[0]).masterGainControl = (args.i() != 0); }},
+
+    // Ping
+    {kMsgPing,                          SIM { const char * ip = args.s(); sim.pong(ip, args.i()); }},
+
+    {nullptr, nullptr}
+};
+
+#undef SIM
+
+static void help(){
+    fprintf(stdout,
+        "Usage: %s [-h|-?] [-v<verbosity>] [-p <port>] [-e] [...]\n"
+        "Simulates an L-ISA Controller (on localhost) for throughput and latency testing.\n"
+        "\nOptions:\n"
+        "\t -h, -?                  Show this help\n"
+        "\t -v<verbosity>           Verbose output (in 0 (none), 1 (error), 2 (info = default), 3 (debug)\n"
+        "\t -p, --port <port>       Port to listen on (default: %hu)\n"
+        "\t -e, --echo              Send feedback for every source parameter/fader change received\n"
+        "\t --sources <n>           Number of sources to send feedback for with --source-rate (default: 96)\n"
+        "\t --source-rate <hz>      Rate at which to send feedback of all source parameters (default: 0 = never)\n"
+        "\t --fader-rate <hz>       Rate at which to send master/reverb fader feedback (default: 0 = never)\n"
+        "\t --stats-interval <s>    Interval at which to log message rates (default: 1, 0 = never)\n"
+        "\t --arrivals <file>       Record arrival time (ns) and address of every message received\n"
+        "\nFeedback is sent to devices registered (%s) with sending enabled (%s).\n"
+        , argv0, kLisaControllerPortDefault, kMsgRegisterDevice, kMsgEnableSendingToDevice
+    );
+}
+
+int main(int argc, char * argv[]){
+
+    argv0 = argv[0];
+
+    while (1) {
+        int option_index = 0;
+        static struct option long_options[] = {
+                {"port",required_argument,0,'p'},
+                {"echo",no_argument,0,'e'},
+                {"sources",required_argument,0,1},
+                {"source-rate",required_argument,0,2},
+                {"fader-rate",required_argument,0,3},
+                {"stats-interval",required_argument,0,4},
+                {"arrivals",required_argument,0,5},
+                {0,0,0,0}
+        };
+
+        int c = getopt_long(argc, argv, "?hv:p:e", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch (c) {
+            case 'p':
+                if (std::atoi(optarg) < 1 || 0xffff < std::atoi(optarg)){
+                    fprintf(stderr, "Invalid port: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                opts.port = std::atoi(optarg);
+                break;
+
+            case 'e':
+                opts.echo = true;
+                break;
+
+            case 1: // --sources
+                if (!isValidSourceId(std::atoi(optarg))){
+                    fprintf(stderr, "Invalid number of sources: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                opts.sources = std::atoi(optarg);
+                break;
+
+            case 2: // --source-rate
+                opts.sourceRate = std::atoi(optarg);
+                break;
+
+            case 3: // --fader-rate
+                opts.faderRate = std::atoi(optarg);
+                break;
+
+            case 4: // --stats-interval
+                opts.statsInterval = std::atoi(optarg);
+                break;
+
+            case 5: // --arrivals
+                opts.arrivalsFile = optarg;
+                break;
+
+            case 'v':
+                opts.logLevel = std::atoi(optarg);
+                break;
+
+            case '?':
+            case 'h':
+                help();
+                return EXIT_SUCCESS;
+
+            default:
+                help();
+                return EXIT_FAILURE;
+        }
+    }
+
+    setLogLevel((LogLevel)opts.logLevel);
+
+    FILE * arrivals = nullptr;
+    if (opts.arrivalsFile != nullptr){
+        arrivals = fopen(opts.arrivalsFile, "w");
+        if (arrivals == nullptr){
+            fprintf(stderr, "Could not open %s\n", opts.arrivalsFile);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ControllerSim sim;
+
+    try {
+        sim.start(opts.port, arrivals);
+    } catch (const std::exception & e){
+        fprintf(stderr, "Could not listen on port %hu: %s\n", opts.port, e.what());
+        return EXIT_FAILURE;
+    }
+
+    LISA_LOG_INFO("Simulating L-ISA Controller on port %hu", opts.port);
+
+    PeriodicTask sourceTask, faderTask, statsTask;
+
+    if (opts.sourceRate > 0){
+        sourceTask.start(std::chrono::microseconds(1000000 / opts.sourceRate), [&sim](){
+            sim.floodSources();
+        });
+    }
+    if (opts.faderRate > 0){
+        faderTask.start(std::chrono::microseconds(1000000 / opts.faderRate), [&sim](){
+            sim.floodFaders();
+        });
+    }
+
+    uint64_t lastReceived = 0, lastSent = 0;
+    if (opts.statsInterval > 0){
+        statsTask.start(std::chrono::seconds(opts.statsInterval), [&](){
+            uint64_t received = sim.received.load(), sent = sim.sent.load();
+            LISA_LOG_INFO("rx %.0f msg/s, tx %.0f msg/s",
+                (double)(received - lastReceived) / opts.statsInterval, (double)(sent - lastSent) / opts.statsInterval);
+            lastReceived = received;
+            lastSent = sent;
+        });
+    }
+
+    // until SIGINT
+    sim.run();
+
+    statsTask.stop();
+    faderTask.stop();
+    sourceTask.stop();
+
+    sim.stop();
+
+    if (arrivals != nullptr){
+        fclose(arrivals);
+    }
+
+    LISA_LOG_INFO("Received %llu messages (%llu unknown, %llu invalid), sent %llu",
+        (unsigned long long)sim.received.load(), (unsigned long long)sim.unknown.load(),
+        (unsigned long long)sim.invalid.load(), (unsigned long long)sim.sent.load());
+    for(int cls = 0; cls < MessageClassCount; cls++){
+        LISA_LOG_INFO("  %-12s %llu", messageClassName((MessageClass_t)cls), (unsigned long long)sim.receivedByClass[cls].load());
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+/**
+* L-ISA Deskbridge
+* Copyright (C) 2025  Philip Tschiemer, https://github.com/tschiemer/lisa-deskbridge
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+ * Replays a capture (see lisa-deskbridge-cli --capture) into a bridge: MIDI input and SQ mixer events are
+ * injected into the bridge, OSC packets from L-ISA Controller into its proxy, all in-process (the bridge is
+ * started detached, ie without MIDI ports or sockets, everything sent to L-ISA Controller is discarded).
+ */
+
+#include <getopt.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "lisa-deskbridge/Bridge.h"
+#include "lisa-deskbridge/Capture.h"
+#include "lisa-deskbridge/Latency.h"
+#include "lisa-deskbridge/MidiReceiver.h"
+#include "lisa-deskbridge/Transport.h"
+#include "lisa-deskbridge/log.h"
+#include "lisa-deskbridge/bridges/SQMitm.h"
+
+using namespace LisaDeskbridge;
+
+static char * argv0 = nullptr;
+
+static struct {
+    int logLevel;
+    double speed;
+    Bridge::BridgeOpts bridgeOpts;
+} opts = {
+    .logLevel = LogLevelError,
+    .speed = 1.0
+};
+
+static void help(){
+    fprintf(stdout,
+        "Usage: %s [-h|-?] [-v<verbosity>] [-s <speed>] [(-o|--bridge-opt <key1>=<value1>)*] <bridge> <capture-file>\n"
+        "Replays a capture into a bridge (with in-process MIDI, mixer and L-ISA Controller stand-ins).\n"
+        "\nOptions:\n"
+        "\t -h, -?                  Show this help\n"
+        "\t -v<verbosity>           Verbose output (in 0 (none), 1 (error = default), 2 (info), 3 (debug)\n"
+        "\t -s, --speed <speed>     Replay speed: 1 = as captured (default), N = N times faster, 0 = as fast as possible\n"
+        "\t -o,--bridge-opt         Pass (multiple) options to bridge using form 'key=value'\n"
+        "\nExamples:\n"
+        "%s -s 0 -o mixer-ip=127.0.0.1 SQ-Mitm show.ldbcap\n"
+        , argv0, argv0
+    );
+}
+
+int main(int argc, char * argv[]){
+
+    argv0 = argv[0];
+
+    while (1) {
+        int option_index = 0;
+        static struct option long_options[] = {
+                {"speed",required_argument,0,'s'},
+                {"bridge-opt", required_argument,0,'o'},
+                {0,0,0,0}
+        };
+
+        int c = getopt_long(argc, argv, "?hv:s:o:", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        std::string arg;
+        size_t pos;
+
+        switch (c) {
+            case 's':
+                opts.speed = std::atof(optarg);
+                if (opts.speed < 0.0){
+                    fprintf(stderr, "Invalid speed: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'o':
+                arg = optarg;
+                pos = arg.find_first_of('=');
+                opts.bridgeOpts[arg.substr(0, pos)] = arg.substr(pos+1);
+                break;
+
+            case 'v':
+                opts.logLevel = std::atoi(optarg);
+                break;
+
+            case '?':
+            case 'h':
+                help();
+                return EXIT_SUCCESS;
+
+            default:
+                help();
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind + 2 != argc){
+        help();
+        return EXIT_FAILURE;
+    }
+
+    setLogLevel((LogLevel)opts.logLevel);
+
+    std::string bridgeName = argv[optind];
+    const char * path = argv[optind + 1];
+
+    CaptureReader reader;
+    if (!reader.open(path)){
+        fprintf(stderr, "Not a (readable) capture: %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    Bridge * bridge = Bridge::factory(bridgeName, opts.bridgeOpts);
+    if (bridge == nullptr){
+        fprintf(stderr, "Invalid bridge: %s\n", bridgeName.data());
+        return EXIT_FAILURE;
+    }
+
+    Bridges::SQMitm * sqMitm = dynamic_cast<Bridges::SQMitm*>(bridge);
+
+    NullTransport transport;
+    bridge->startDetached(transport);
+
+    LisaControllerProxy & proxy = bridge->getLisaControllerProxy();
+    IpEndpointName controller(kLisaControllerIpDefault, kLisaControllerPortDefault);
+
+    uint64_t counts[CaptureOscTx + 1] = {};
+    uint64_t skipped = 0;
+
+    // reused (records are large)
+    CaptureReader::Record * record = new CaptureReader::Record;
+
+    uint64_t firstTime = 0;
+    uint64_t lastTime = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while(reader.next(*record)){
+
+        if (firstTime == 0){
+            firstTime = record->time;
+        }
+
+        // inputs carry their arrival time, so records may be slightly out of order
+        if (record->time < firstTime){
+            record->time = firstTime;
+        }
+        if (lastTime < record->time){
+            lastTime = record->time;
+        }
+
+        if (opts.speed > 0.0){
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds((uint64_t)((double)(record->time - firstTime) / opts.speed)));
+        }
+
+        libremidi::message message;
+        MidiReceiver * receiver;
+        int32_t args[kCaptureMixerEventArgs];
+
+        switch(record->type){
+            case CaptureMidiIn:
+                receiver = MidiReceiver::byCaptureId(record->port);
+                if (receiver == nullptr){
+                    skipped++;
+                    continue;
+                }
+                message.bytes.assign(record->data, record->data + record->size);
+                {
+                    IngressScope ingress(ingressTagNow(LatencySourceMidi));
+                    receiver->inject(message);
+                }
+                break;
+
+            case CaptureMixerEvent:
+                if (sqMitm == nullptr || record->size != sizeof(args) || MixerEventCount <= record->port){
+                    skipped++;
+                    continue;
+                }
+                std::memcpy(args, record->data, sizeof(args));
+                {
+                    IngressScope ingress(ingressTagNow(LatencySourceMixer));
+                    sqMitm->onMixerEvent((MixerEvent_t)record->port, args[0], args[1], args[2], args[3]);
+                }
+                break;
+
+            case CaptureOscRx:
+                proxy.ProcessPacket(record->data, record->size, controller);
+                break;
+
+            case CaptureOscTx:
+                // only counted, to compare with what the replay sends
+                break;
+
+            default:
+                skipped++;
+                continue;
+        }
+
+        counts[record->type]++;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bridge->stop();
+
+    delete record;
+
+    LisaControllerProxy::TxStats stats = proxy.getTxStats();
+
+    fprintf(stdout, "Replayed %.3f s of capture in %.3f s\n", (double)(lastTime - firstTime) / 1e9, elapsed);
+    fprintf(stdout, "  MIDI messages:       %llu\n", (unsigned long long)counts[CaptureMidiIn]);
+    fprintf(stdout, "  mixer events:        %llu\n", (unsigned long long)counts[CaptureMixerEvent]);
+    fprintf(stdout, "  OSC received:        %llu\n", (unsigned long long)counts[CaptureOscRx]);
+    fprintf(stdout, "  skipped:             %llu\n", (unsigned long long)skipped);
+    fprintf(stdout, "OSC datagrams sent:    %llu (captured %llu, %llu dropped, %llu system calls)\n",
+        (unsigned long long)stats.sent, (unsigned long long)counts[CaptureOscTx], (unsigned long long)stats.dropped,
+        (unsigned long long)stats.syscalls);
+
+    for(int source = 0; source < LatencySourceCount; source++){
+        LatencyHistogram::Summary s = proxy.getLatency((LatencySource_t)source).summarize();
+        if (s.count > 0){
+            fprintf(stdout, "%s to OSC latency:  p50 %.1f us, p99 %.1f us, max %.1f us (%llu)\n",
+                latencySourceName((LatencySource_t)source), (double)s.p50 / 1e3, (double)s.p99 / 1e3, (double)s.max / 1e3,
+                (unsigned long long)s.count);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}